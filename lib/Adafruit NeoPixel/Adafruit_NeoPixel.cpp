@@ -78,7 +78,8 @@
   @return  Adafruit_NeoPixel object. Call the begin() function before use.
 */
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
-    : begun(false), brightness(0), pixels(NULL), endTime(0) {
+    : begun(false), dirty(true), externalPixels(false), brightness(0),
+      powerScale(256), levelSums(), pixels(NULL), scaled(NULL), endTime(0) {
   updateType(t);
   updateLength(n);
   setPin(p);
@@ -114,8 +115,10 @@ Adafruit_NeoPixel::Adafruit_NeoPixel()
 #if defined(NEO_KHZ400)
       is800KHz(true),
 #endif
-      begun(false), numLEDs(0), numBytes(0), pin(-1), brightness(0),
-      pixels(NULL), rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0) {
+      begun(false), dirty(true), externalPixels(false), numLEDs(0),
+      numBytes(0), pin(-1), brightness(0), powerScale(256), levelSums(),
+      pixels(NULL), scaled(NULL), rOffset(1), gOffset(0), bOffset(2),
+      wOffset(1), endTime(0) {
 }
 
 /*!
@@ -127,9 +130,12 @@ Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   // by indirectly calling into espShow()
   memset(pixels, 0, numBytes);
   numLEDs = numBytes = 0;
+  dirty = true;
   show();
 #endif
-  free(pixels);
+  if (!externalPixels)
+    free(pixels);
+  free(scaled);
   if (pin >= 0)
     pinMode(pin, INPUT);
 }
@@ -156,9 +162,15 @@ void Adafruit_NeoPixel::begin(void) {
            type).
 */
 void Adafruit_NeoPixel::updateLength(uint16_t n) {
-  free(pixels); // Free existing data (if any)
+  if (!externalPixels)
+    free(pixels); // Free existing data (if any)
+  externalPixels = false;
+  free(scaled);
+  scaled = NULL;
 
   // Allocate new data -- note: ALL PIXELS ARE CLEARED
+  dirty = true;
+  memset(levelSums, 0, sizeof(levelSums));
   numBytes = n * ((wOffset == rOffset) ? 3 : 4);
   if ((pixels = (uint8_t *)malloc(numBytes))) {
     memset(pixels, 0, numBytes);
@@ -192,6 +204,7 @@ void Adafruit_NeoPixel::updateType(neoPixelType t) {
   rOffset = (t >> 4) & 0b11; // regarding R/G/B/W offsets
   gOffset = (t >> 2) & 0b11;
   bOffset = t & 0b11;
+  dirty = true;
 #if defined(NEO_KHZ400)
   is800KHz = (t < 256); // 400 KHz flag is 1<<8
 #endif
@@ -205,6 +218,32 @@ void Adafruit_NeoPixel::updateType(neoPixelType t) {
   }
 }
 
+/*!
+  @brief   Use caller-owned memory as the pixel buffer instead of the
+           library's own allocation, e.g. a slice of a larger framebuffer
+           shared by several strips. Any buffer previously allocated by the
+           library is freed; the new one is never freed by the library.
+           Existing contents are kept, not cleared.
+  @param   buf  Pixel memory in device-native format, at least n * 3 bytes
+                (n * 4 for RGBW types). NULL detaches and leaves the strip
+                with zero length.
+  @param   n    Number of pixels in buf.
+  @note    A later updateLength() (or an updateType() that changes the
+           bytes per pixel) goes back to a library-allocated buffer.
+*/
+void Adafruit_NeoPixel::setPixelBuffer(uint8_t *buf, uint16_t n) {
+  if (!externalPixels)
+    free(pixels);
+  pixels = buf;
+  externalPixels = (buf != NULL);
+  numLEDs = buf ? n : 0;
+  numBytes = numLEDs * ((wOffset == rOffset) ? 3 : 4);
+  free(scaled);
+  scaled = NULL;
+  dirty = true;
+  recountLevels(); // Existing contents are kept, so count them once here
+}
+
 // RP2040 specific driver
 #if defined(ARDUINO_ARCH_RP2040)
 void Adafruit_NeoPixel::rp2040Init(uint8_t pin, bool is800KHz)
@@ -425,8 +464,20 @@ extern "C" void k210Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes,
 */
 void Adafruit_NeoPixel::show(void) {
 
-  if (!pixels)
-    return;
+  if (!this->pixels || !dirty)
+    return; // Nothing allocated, or frame unchanged since the last show()
+  dirty = false; // Before sending, so writes made during the transfer (from
+                 // another task while the RMT write blocks) mark the next frame
+
+  // With a power scale set, a scaled copy is sent instead of the buffer.
+  // The local 'pixels' shadows the member for all the output code below,
+  // so the stored colors are never touched.
+  uint8_t *pixels = this->pixels;
+  if (powerScale < 256 && (scaled || (scaled = (uint8_t *)malloc(numBytes)))) {
+    for (uint16_t i = 0; i < numBytes; i++)
+      scaled[i] = (pixels[i] * powerScale) >> 8;
+    pixels = scaled;
+  }
 
   // Data latch = 300+ microsecond pause in the output stream. Rather than
   // put a delay at the end of the function, the ending time is noted and
@@ -3345,11 +3396,16 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
       p = &pixels[n * 3];     // 3 bytes per pixel
     } else {                  // Is a WRGB-type strip
       p = &pixels[n * 4];     // 4 bytes per pixel
+      levelSums[wOffset] -= p[wOffset];
       p[wOffset] = 0;         // But only R,G,B passed -- set W to 0
     }
+    levelSums[rOffset] += (uint32_t)r - p[rOffset]; // See getLevelSum()
+    levelSums[gOffset] += (uint32_t)g - p[gOffset];
+    levelSums[bOffset] += (uint32_t)b - p[bOffset];
     p[rOffset] = r; // R,G,B always stored
     p[gOffset] = g;
     p[bOffset] = b;
+    dirty = true;
   }
 }
 
@@ -3378,11 +3434,16 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
       p = &pixels[n * 3];     // 3 bytes per pixel (ignore W)
     } else {                  // Is a WRGB-type strip
       p = &pixels[n * 4];     // 4 bytes per pixel
+      levelSums[wOffset] += (uint32_t)w - p[wOffset];
       p[wOffset] = w;         // Store W
     }
+    levelSums[rOffset] += (uint32_t)r - p[rOffset];
+    levelSums[gOffset] += (uint32_t)g - p[gOffset];
+    levelSums[bOffset] += (uint32_t)b - p[bOffset];
     p[rOffset] = r; // Store R,G,B
     p[gOffset] = g;
     p[bOffset] = b;
+    dirty = true;
   }
 }
 
@@ -3406,11 +3467,18 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
     } else {
       p = &pixels[n * 4];
       uint8_t w = (uint8_t)(c >> 24);
-      p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
+      if (brightness)
+        w = (w * brightness) >> 8;
+      levelSums[wOffset] += (uint32_t)w - p[wOffset];
+      p[wOffset] = w;
     }
+    levelSums[rOffset] += (uint32_t)r - p[rOffset];
+    levelSums[gOffset] += (uint32_t)g - p[gOffset];
+    levelSums[bOffset] += (uint32_t)b - p[bOffset];
     p[rOffset] = r;
     p[gOffset] = g;
     p[bOffset] = b;
+    dirty = true;
   }
 }
 
@@ -3424,9 +3492,12 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
                   in-bounds, no clipping is performed. 0 if unspecified.
   @param   count  Number of pixels to fill, as a positive value. Passing
                   0 or leaving unspecified will fill to end of strip.
+  @note    The color is converted to device order (and scaled by the strip
+           brightness) once, then replicated with block copies, rather than
+           going through setPixelColor() for every pixel.
 */
 void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
-  uint16_t i, end;
+  uint16_t end;
 
   if (first >= numLEDs) {
     return; // If first LED is past end of strip, nothing to do
@@ -3443,38 +3514,50 @@ void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
       end = numLEDs;
   }
 
-  for (i = first; i < end; i++) {
-    this->setPixelColor(i, c);
+  // Build the first pixel in device order, then double the filled span
+  // with memcpy() until the range is covered.
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint8_t *dst = &pixels[first * bpp];
+  uint32_t total = (uint32_t)(end - first) * bpp, filled;
+  uint8_t r = (uint8_t)(c >> 16), g = (uint8_t)(c >> 8), b = (uint8_t)c,
+          w = (uint8_t)(c >> 24);
+  if (brightness) { // See notes in setBrightness()
+    r = (r * brightness) >> 8;
+    g = (g * brightness) >> 8;
+    b = (b * brightness) >> 8;
+    w = (w * brightness) >> 8;
+  }
+  // Power estimate: a whole-strip fill needs no look at the old contents,
+  // a partial one takes its range out of the sums before overwriting it.
+  uint16_t n = end - first;
+  if (n == numLEDs) {
+    memset(levelSums, 0, sizeof(levelSums));
+  } else {
+    for (uint32_t i = 0; i < total; i += bpp)
+      for (uint8_t k = 0; k < bpp; k++)
+        levelSums[k] -= dst[i + k];
   }
+  if (bpp == 4)
+    levelSums[wOffset] += (uint32_t)w * n;
+  levelSums[rOffset] += (uint32_t)r * n;
+  levelSums[gOffset] += (uint32_t)g * n;
+  levelSums[bOffset] += (uint32_t)b * n;
+  if (bpp == 4)
+    dst[wOffset] = w;
+  dst[rOffset] = r;
+  dst[gOffset] = g;
+  dst[bOffset] = b;
+  for (filled = bpp; filled < total; filled *= 2) {
+    memcpy(dst + filled, dst, (total - filled < filled) ? total - filled : filled);
+  }
+  dirty = true;
 }
 
-/*!
-  @brief   Convert hue, saturation and value into a packed 32-bit RGB color
-           that can be passed to setPixelColor() or other RGB-compatible
-           functions.
-  @param   hue  An unsigned 16-bit value, 0 to 65535, representing one full
-                loop of the color wheel, which allows 16-bit hues to "roll
-                over" while still doing the expected thing (and allowing
-                more precision than the wheel() function that was common to
-                prior NeoPixel examples).
-  @param   sat  Saturation, 8-bit value, 0 (min or pure grayscale) to 255
-                (max or pure hue). Default of 255 if unspecified.
-  @param   val  Value (brightness), 8-bit value, 0 (min / black / off) to
-                255 (max or full brightness). Default of 255 if unspecified.
-  @return  Packed 32-bit RGB with the most significant byte set to 0 -- the
-           white element of WRGB pixels is NOT utilized. Result is linearly
-           but not perceptually correct, so you may want to pass the result
-           through the gamma32() function (or your own gamma-correction
-           operation) else colors may appear washed out. This is not done
-           automatically by this function because coders may desire a more
-           refined gamma-correction function than the simplified
-           one-size-fits-all operation of gamma32(). Diffusing the LEDs also
-           really seems to help when using low-saturation colors.
-*/
-uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
-
-  uint8_t r, g, b;
-
+// Shared by ColorHSV() and the span functions below so that the batch
+// versions give bit-identical results. Outputs 8-bit R,G,B after saturation
+// and value have been applied.
+static inline void hsvToRGB(uint16_t hue, uint8_t sat, uint8_t val,
+                            uint8_t &r, uint8_t &g, uint8_t &b) {
   // Remap 0-65535 to 0-1529. Pure red is CENTERED on the 64K rollover;
   // 0 is not the start of pure red, but the midpoint...a few values above
   // zero and a few below 65536 all yield pure red (similarly, 32768 is the
@@ -3483,7 +3566,7 @@ uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
   // (not 1536, more on that below), but the full unsigned 16-bit type was
   // chosen for hue so that one's code can easily handle a contiguous color
   // wheel by allowing hue to roll over in either direction.
-  hue = (hue * 1530L + 32768) / 65536;
+  hue = ((uint32_t)hue * 1530 + 32768) >> 16;
   // Because red is centered on the rollover point (the +32768 above,
   // essentially a fixed-point +0.5), the above actually yields 0 to 1530,
   // where 0 and 1530 would yield the same thing. Rather than apply a
@@ -3538,13 +3621,120 @@ uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
     g = b = 0;
   }
 
-  // Apply saturation and value to R,G,B, pack into 32-bit result:
-  uint32_t v1 = 1 + val;  // 1 to 256; allows >>8 instead of /255
-  uint16_t s1 = 1 + sat;  // 1 to 256; same reason
-  uint8_t s2 = 255 - sat; // 255 to 0
-  return ((((((r * s1) >> 8) + s2) * v1) & 0xff00) << 8) |
-         (((((g * s1) >> 8) + s2) * v1) & 0xff00) |
-         (((((b * s1) >> 8) + s2) * v1) >> 8);
+  // Apply saturation and value to R,G,B. Both are identities at 255, which
+  // is the common rainbow case, so skip the multiplies then:
+  if (sat != 255) {
+    uint16_t s1 = 1 + sat;  // 1 to 256; allows >>8 instead of /255
+    uint8_t s2 = 255 - sat; // 255 to 0
+    r = ((r * s1) >> 8) + s2;
+    g = ((g * s1) >> 8) + s2;
+    b = ((b * s1) >> 8) + s2;
+  }
+  if (val != 255) {
+    uint16_t v1 = 1 + val;  // 1 to 256; same reason
+    r = (r * v1) >> 8;
+    g = (g * v1) >> 8;
+    b = (b * v1) >> 8;
+  }
+}
+
+
+/*!
+  @brief   Convert hue, saturation and value into a packed 32-bit RGB color
+           that can be passed to setPixelColor() or other RGB-compatible
+           functions.
+  @param   hue  An unsigned 16-bit value, 0 to 65535, representing one full
+                loop of the color wheel, which allows 16-bit hues to "roll
+                over" while still doing the expected thing (and allowing
+                more precision than the wheel() function that was common to
+                prior NeoPixel examples).
+  @param   sat  Saturation, 8-bit value, 0 (min or pure grayscale) to 255
+                (max or pure hue). Default of 255 if unspecified.
+  @param   val  Value (brightness), 8-bit value, 0 (min / black / off) to
+                255 (max or full brightness). Default of 255 if unspecified.
+  @return  Packed 32-bit RGB with the most significant byte set to 0 -- the
+           white element of WRGB pixels is NOT utilized. Result is linearly
+           but not perceptually correct, so you may want to pass the result
+           through the gamma32() function (or your own gamma-correction
+           operation) else colors may appear washed out. This is not done
+           automatically by this function because coders may desire a more
+           refined gamma-correction function than the simplified
+           one-size-fits-all operation of gamma32(). Diffusing the LEDs also
+           really seems to help when using low-saturation colors.
+*/
+uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
+  uint8_t r, g, b;
+  hsvToRGB(hue, sat, val, r, g, b);
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+/*!
+  @brief   Convert arrays of hue, saturation and value into packed 32-bit
+           RGB colors. Same results as calling ColorHSV() for each element,
+           without the per-call overhead.
+  @param   out    Destination, 'count' packed colors.
+  @param   hue    Hues, 0 to 65535, one per element.
+  @param   sat    Saturations, one per element, or NULL for 255 throughout.
+  @param   val    Values, one per element, or NULL for 255 throughout.
+  @param   count  Number of elements.
+*/
+void Adafruit_NeoPixel::ColorHSV(uint32_t *out, const uint16_t *hue,
+                                 const uint8_t *sat, const uint8_t *val,
+                                 uint16_t count) {
+  uint8_t r, g, b;
+  for (uint16_t i = 0; i < count; i++) {
+    hsvToRGB(hue[i], sat ? sat[i] : 255, val ? val[i] : 255, r, g, b);
+    out[i] = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+}
+
+/*!
+  @brief   Set a run of pixels from arrays of hue, saturation and value.
+           Colors go straight into the pixel buffer in device order, with
+           optional gamma correction and the strip brightness applied, so
+           the result is identical to setPixelColor(ColorHSV(...)) per
+           pixel (through gamma32() if gammify is set).
+  @param   first    Index of first pixel.
+  @param   count    Number of pixels, clipped to the end of the strip.
+  @param   hue      Hues, 0 to 65535, one per pixel.
+  @param   sat      Saturations, one per pixel, or NULL for 255 throughout.
+  @param   val      Values, one per pixel, or NULL for 255 throughout.
+  @param   gammify  If true, apply gamma8() to each component.
+*/
+void Adafruit_NeoPixel::setPixelsHSV(uint16_t first, uint16_t count,
+                                     const uint16_t *hue, const uint8_t *sat,
+                                     const uint8_t *val, bool gammify) {
+  if (first >= numLEDs)
+    return;
+  if (count > numLEDs - first)
+    count = numLEDs - first;
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint8_t *p = &pixels[first * bpp];
+  uint8_t r, g, b;
+  for (uint16_t i = 0; i < count; i++, p += bpp) {
+    hsvToRGB(hue[i], sat ? sat[i] : 255, val ? val[i] : 255, r, g, b);
+    if (gammify) {
+      r = gamma8(r);
+      g = gamma8(g);
+      b = gamma8(b);
+    }
+    if (brightness) { // See notes in setBrightness()
+      r = (r * brightness) >> 8;
+      g = (g * brightness) >> 8;
+      b = (b * brightness) >> 8;
+    }
+    if (bpp == 4) {
+      levelSums[wOffset] -= p[wOffset];
+      p[wOffset] = 0; // ColorHSV() never sets white
+    }
+    levelSums[rOffset] += (uint32_t)r - p[rOffset];
+    levelSums[gOffset] += (uint32_t)g - p[gOffset];
+    levelSums[bOffset] += (uint32_t)b - p[bOffset];
+    p[rOffset] = r;
+    p[gOffset] = g;
+    p[bOffset] = b;
+  }
+  dirty = true;
 }
 
 /*!
@@ -3642,6 +3832,8 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
       *ptr++ = (c * scale) >> 8;
     }
     brightness = newBrightness;
+    dirty = true;
+    recountLevels(); // Every byte changed anyway
   }
 }
 
@@ -3654,7 +3846,62 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const { return brightness - 1; }
 /*!
   @brief   Fill the whole NeoPixel strip with 0 / black / off.
 */
-void Adafruit_NeoPixel::clear(void) { memset(pixels, 0, numBytes); }
+void Adafruit_NeoPixel::clear(void) {
+  memset(pixels, 0, numBytes);
+  memset(levelSums, 0, sizeof(levelSums));
+  dirty = true;
+}
+
+/*!
+  @brief   Sum of all color bytes in the pixel buffer, as sent to the
+           strip (strip brightness included, power scale not). Every
+           drawing function keeps a running sum per channel up to date as
+           it writes, so this never looks at the buffer. The sums are not
+           updated atomically: writers and show() must not run at the
+           same time.
+  @return  Sum of all R, G, B (and W) values.
+*/
+uint32_t Adafruit_NeoPixel::getLevelSum(void) const {
+  return levelSums[0] + levelSums[1] + levelSums[2] + levelSums[3];
+}
+
+/*!
+  @brief   Count the level sums from the buffer, for writes that did not
+           keep them: setBrightness(), a newly attached buffer, and direct
+           writes flagged with markDirty().
+*/
+void Adafruit_NeoPixel::recountLevels(void) {
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  memset(levelSums, 0, sizeof(levelSums));
+  for (uint16_t i = 0; i < numBytes; i += bpp)
+    for (uint8_t k = 0; k < bpp; k++)
+      levelSums[k] += pixels[i + k];
+}
+
+/*!
+  @brief   Estimate the supply current of the strip for the current
+           contents, before any power scale.
+  @return  Estimated current in milliamps: NEO_MA_PER_CHANNEL per channel
+           at full level plus NEO_MA_IDLE per pixel.
+*/
+uint32_t Adafruit_NeoPixel::estimateMilliamps(void) const {
+  return (uint32_t)((uint64_t)getLevelSum() * NEO_MA_PER_CHANNEL / 255) +
+         (uint32_t)numLEDs * NEO_MA_IDLE;
+}
+
+/*!
+  @brief   Scale all output by a factor when it is sent, without changing
+           the stored colors. Used to keep a strip under a power budget.
+  @param   scale  256 = unscaled, 128 = half, 0 = off.
+*/
+void Adafruit_NeoPixel::setPowerScale(uint16_t scale) {
+  if (scale > 256)
+    scale = 256;
+  if (scale != powerScale) {
+    powerScale = scale;
+    dirty = true;
+  }
+}
 
 // A 32-bit variant of gamma8() that applies the same function
 // to all components of a packed RGB or WRGB value.
@@ -3673,6 +3920,31 @@ uint32_t Adafruit_NeoPixel::gamma32(uint32_t x) {
   return x; // Packed 32-bit return
 }
 
+/*!
+  @brief   Apply gamma32() to an array of packed colors in place.
+  @param   x      Packed RGB or WRGB colors.
+  @param   count  Number of elements.
+*/
+void Adafruit_NeoPixel::gamma32(uint32_t *x, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t c = x[i];
+    x[i] = ((uint32_t)gamma8(c >> 24) << 24) |
+           ((uint32_t)gamma8((uint8_t)(c >> 16)) << 16) |
+           ((uint32_t)gamma8((uint8_t)(c >> 8)) << 8) | gamma8((uint8_t)c);
+  }
+}
+
+/*!
+  @brief   Apply sine8() to an array of angles.
+  @param   out    Destination, may be the same array as 'x'.
+  @param   x      Input angles, 0-255 for one full circle.
+  @param   count  Number of elements.
+*/
+void Adafruit_NeoPixel::sine8(uint8_t *out, const uint8_t *x, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++)
+    out[i] = sine8(x[i]);
+}
+
 /*!
   @brief   Fill NeoPixel strip with one or more cycles of hues.
            Everyone loves the rainbow swirl so much, now it's canon!
@@ -3693,11 +3965,30 @@ uint32_t Adafruit_NeoPixel::gamma32(uint32_t x) {
 */
 void Adafruit_NeoPixel::rainbow(uint16_t first_hue, int8_t reps,
   uint8_t saturation, uint8_t brightness, bool gammify) {
-  for (uint16_t i=0; i<numLEDs; i++) {
-    uint16_t hue = first_hue + (i * reps * 65536) / numLEDs;
-    uint32_t color = ColorHSV(hue, saturation, brightness);
-    if (gammify) color = gamma32(color);
-    setPixelColor(i, color);
+  // Hues are generated in chunks and handed to setPixelsHSV(). The step
+  // (reps * 65536) / numLEDs is stepped as quotient plus remainder, which
+  // gives exactly the truncated per-pixel division without dividing.
+  uint16_t hues[32];
+  uint8_t sats[32], vals[32];
+  memset(sats, saturation, sizeof(sats));
+  memset(vals, brightness, sizeof(vals));
+  if (!numLEDs)
+    return;
+  uint32_t span = (uint32_t)(reps < 0 ? -reps : reps) * 65536;
+  uint32_t quot = span / numLEDs, rem = span % numLEDs;
+  uint32_t offset = 0, frac = 0; // |i * reps * 65536| / numLEDs, remainder
+  for (uint16_t i = 0; i < numLEDs; i += 32) {
+    uint16_t n = (numLEDs - i < 32) ? numLEDs - i : 32;
+    for (uint16_t j = 0; j < n; j++) {
+      hues[j] = first_hue + (reps < 0 ? -offset : offset);
+      offset += quot;
+      if ((frac += rem) >= numLEDs) {
+        frac -= numLEDs;
+        offset++;
+      }
+    }
+    setPixelsHSV(i, n, hues, saturation == 255 ? NULL : sats,
+                 brightness == 255 ? NULL : vals, gammify);
   }
 }
 
@@ -138,6 +138,15 @@
 #define NEO_KHZ400 0x0100 ///< 400 KHz data transmission
 #endif
 
+// Current model used by estimateMilliamps(). Typical WS2812B figures;
+// redefine before including this header for other parts.
+#ifndef NEO_MA_PER_CHANNEL
+#define NEO_MA_PER_CHANNEL 20 ///< mA drawn by one channel at full level
+#endif
+#ifndef NEO_MA_IDLE
+#define NEO_MA_IDLE 1 ///< Quiescent mA per pixel, even when black
+#endif
+
 // If 400 KHz support is enabled, the third parameter to the constructor
 // requires a 16-bit value (in order to select 400 vs 800 KHz speed).
 // If only 800 KHz is enabled (as is default on ATtiny), an 8-bit value
@@ -240,6 +249,7 @@ public:
   void setBrightness(uint8_t);
   void clear(void);
   void updateLength(uint16_t n);
+  void setPixelBuffer(uint8_t *buf, uint16_t n);
   void updateType(neoPixelType t);
   /*!
     @brief   Check whether a call to show() will start sending data
@@ -288,9 +298,35 @@ public:
              POV or light-painting projects). There is no bounds checking
              on the array, creating tremendous potential for mayhem if one
              writes past the ends of the buffer. Great power, great
-             responsibility and all that.
+             responsibility and all that. Call markDirty() after writing
+             through this pointer, or show() will skip the frame.
   */
   uint8_t *getPixels(void) const { return pixels; };
+  /*!
+    @brief   Flag the pixel buffer as changed, so the next show() transmits
+             it. setPixelColor(), fill(), clear() and setBrightness() do
+             this automatically; it's only needed after writing directly
+             into the buffer returned by getPixels().
+  */
+  void markDirty(void) {
+    dirty = true;
+    recountLevels();
+  }
+  /*!
+    @brief   Like markDirty(), for writers that know the per-channel sums
+             of the bytes they left in the buffer, so no recount is needed.
+    @param   sums  Sum of the bytes at each offset within a pixel, 4
+                   entries (the last one 0 on RGB strips).
+  */
+  void markDirty(const uint32_t *sums) {
+    dirty = true;
+    memcpy(levelSums, sums, sizeof(levelSums));
+  }
+  /*!
+    @brief   Check whether the pixel buffer changed since the last show().
+    @return  true if show() will transmit, false if it will return at once.
+  */
+  bool isDirty(void) const { return dirty; }
   uint8_t getBrightness(void) const;
   /*!
     @brief   Retrieve the pin number used for NeoPixel data output.
@@ -362,6 +398,11 @@ public:
     return ((uint32_t)w << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
   }
   static uint32_t ColorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+  static void ColorHSV(uint32_t *out, const uint16_t *hue, const uint8_t *sat,
+                       const uint8_t *val, uint16_t count);
+  void setPixelsHSV(uint16_t first, uint16_t count, const uint16_t *hue,
+                    const uint8_t *sat = NULL, const uint8_t *val = NULL,
+                    bool gammify = false);
   /*!
     @brief   A gamma-correction function for 32-bit packed RGB or WRGB
              colors. Makes color transitions appear more perceptially
@@ -375,6 +416,8 @@ public:
              function instead.
   */
   static uint32_t gamma32(uint32_t x);
+  static void gamma32(uint32_t *x, uint16_t count);
+  static void sine8(uint8_t *out, const uint8_t *x, uint16_t count);
 
   void rainbow(uint16_t first_hue = 0, int8_t reps = 1,
                uint8_t saturation = 255, uint8_t brightness = 255,
@@ -382,7 +425,17 @@ public:
 
   static neoPixelType str2order(const char *v);
 
+  uint32_t getLevelSum(void) const;
+  uint32_t estimateMilliamps(void) const;
+  void setPowerScale(uint16_t scale);
+  /*!
+    @brief   Retrieve the power scale set with setPowerScale().
+    @return  256 = unscaled, down to 0 = off.
+  */
+  uint16_t getPowerScale(void) const { return powerScale; }
+
 private:
+  void recountLevels(void);
 #if defined(ARDUINO_ARCH_RP2040)
   void  rp2040Init(uint8_t pin, bool is800KHz);
   void  rp2040Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes, bool is800KHz);
@@ -393,11 +446,16 @@ protected:
   bool is800KHz; ///< true if 800 KHz pixels
 #endif
   bool begun;         ///< true if begin() previously called
+  volatile bool dirty; ///< true if pixels changed since show() started sending
+  bool externalPixels; ///< true if 'pixels' is caller-owned (not freed)
   uint16_t numLEDs;   ///< Number of RGB LEDs in strip
   uint16_t numBytes;  ///< Size of 'pixels' buffer below
   int16_t pin;        ///< Output pin number (-1 if not yet set)
   uint8_t brightness; ///< Strip brightness 0-255 (stored as +1)
+  uint16_t powerScale; ///< Output scale 0-256 applied by show()
+  uint32_t levelSums[4]; ///< Sum of the bytes at each pixel offset, see getLevelSum()
   uint8_t *pixels;    ///< Holds LED color values (3 or 4 bytes each)
+  uint8_t *scaled;    ///< Scaled copy sent by show() while powerScale < 256
   uint8_t rOffset;    ///< Red index within each 3- or 4-byte pixel
   uint8_t gOffset;    ///< Index of green byte
   uint8_t bOffset;    ///< Index of blue byte
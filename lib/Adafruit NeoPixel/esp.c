@@ -20,6 +20,8 @@
 #if defined(ESP32)
 
 #include <Arduino.h>
+#include "esp_heap_caps.h"
+#include "esp_rmt_encode.h"
 
 #if defined(ESP_IDF_VERSION)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -53,7 +55,10 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
     uint32_t requiredSize = numBytes * 8;
     if (requiredSize > led_data_size) {
       free(led_data);
-      if (led_data = (rmt_data_t *)malloc(requiredSize * sizeof(rmt_data_t))) {
+      // Keep the encoded symbols in internal RAM even when malloc() would
+      // place a buffer this size in PSRAM.
+      if (led_data = (rmt_data_t *)heap_caps_malloc(requiredSize * sizeof(rmt_data_t),
+                                                    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) {
         led_data_size = requiredSize;
       } else {
         led_data_size = 0;
@@ -85,23 +90,12 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
       }
 
       if (rmtPin >= 0) {
-        int i=0;
-        for (int b=0; b < numBytes; b++) {
-          for (int bit=0; bit<8; bit++){
-            if ( pixels[b] & (1<<(7-bit)) ) {
-              led_data[i].level0 = 1;
-              led_data[i].duration0 = 8;
-              led_data[i].level1 = 0;
-              led_data[i].duration1 = 4;
-            } else {
-              led_data[i].level0 = 1;
-              led_data[i].duration0 = 4;
-              led_data[i].level1 = 0;
-              led_data[i].duration1 = 8;
-            }
-            i++;
-          }
-        }
+        // 10 MHz RMT clock: 4/8 and 8/4 ticks at 800 KHz, as the loop here
+        // always sent. NEO_KHZ400 strips get WS2811 timing (5/20 and 12/13
+        // ticks) like on IDF 4, where they used to get the 800 KHz items.
+        neo_rmt_timing_t timing = neoRmtTiming(10000000, is800KHz);
+        size_t done;
+        neoRmtEncode(pixels, numBytes, (uint32_t *)led_data, requiredSize, &timing, &done);
 
         rmtWrite(pin, led_data, numBytes * 8, RMT_WAIT_FOR_EVER);
       }
@@ -122,25 +116,14 @@ void espInit() {
 #else
 
 #include "driver/rmt.h"
+#include "soc/soc_memory_layout.h"
 
 
 // This code is adapted from the ESP-IDF v3.4 RMT "led_strip" example, altered
 // to work with the Arduino version of the ESP-IDF (3.2)
 
-#define WS2812_T0H_NS (400)
-#define WS2812_T0L_NS (850)
-#define WS2812_T1H_NS (800)
-#define WS2812_T1L_NS (450)
-
-#define WS2811_T0H_NS (500)
-#define WS2811_T0L_NS (2000)
-#define WS2811_T1H_NS (1200)
-#define WS2811_T1L_NS (1300)
-
-static uint32_t t0h_ticks = 0;
-static uint32_t t1h_ticks = 0;
-static uint32_t t0l_ticks = 0;
-static uint32_t t1l_ticks = 0;
+// Bit timings are in esp_rmt_encode.h
+static neo_rmt_timing_t timing;
 
 // Limit the number of RMT channels available for the Neopixels. Defaults to all
 // channels (8 on ESP32, 4 on ESP32-S2 and S3). Redefining this value will free
@@ -152,6 +135,12 @@ static uint32_t t1l_ticks = 0;
 
 bool rmt_reserved_channels[ADAFRUIT_RMT_CHANNEL_MAX];
 
+// The translator below runs from the RMT interrupt, which must not read
+// PSRAM (the cache is off during flash writes). Pixel buffers in external
+// RAM are copied here first; it grows to the largest strip shown.
+static uint8_t *staging = NULL;
+static uint32_t staging_size = 0;
+
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
@@ -160,31 +149,24 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ t0h_ticks, 1, t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ t1h_ticks, 1, t1l_ticks, 0 }}}; //Logical 1
-    size_t size = 0;
-    size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
-    rmt_item32_t *pdest = dest;
-    while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
-        size++;
-        psrc++;
-    }
-    *translated_size = size;
-    *item_num = num;
+    *item_num = neoRmtEncode((const uint8_t *)src, src_size, (uint32_t *)dest,
+                             wanted_num, &timing, translated_size);
 }
 
 void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+    if (esp_ptr_external_ram(pixels)) {
+        if (numBytes > staging_size) {
+            heap_caps_free(staging);
+            staging = (uint8_t *)heap_caps_malloc(numBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+            staging_size = staging ? numBytes : 0;
+        }
+        if (!staging) {
+            return;
+        }
+        memcpy(staging, pixels, numBytes);
+        pixels = staging;
+    }
+
     // Reserve channel
     rmt_channel_t channel = ADAFRUIT_RMT_CHANNEL_MAX;
     for (size_t i = 0; i < ADAFRUIT_RMT_CHANNEL_MAX; i++) {
@@ -243,19 +225,7 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
 #endif
 
     // NS to tick converter
-    float ratio = (float)counter_clk_hz / 1e9;
-
-    if (is800KHz) {
-        t0h_ticks = (uint32_t)(ratio * WS2812_T0H_NS);
-        t0l_ticks = (uint32_t)(ratio * WS2812_T0L_NS);
-        t1h_ticks = (uint32_t)(ratio * WS2812_T1H_NS);
-        t1l_ticks = (uint32_t)(ratio * WS2812_T1L_NS);
-    } else {
-        t0h_ticks = (uint32_t)(ratio * WS2811_T0H_NS);
-        t0l_ticks = (uint32_t)(ratio * WS2811_T0L_NS);
-        t1h_ticks = (uint32_t)(ratio * WS2811_T1H_NS);
-        t1l_ticks = (uint32_t)(ratio * WS2811_T1L_NS);
-    }
+    timing = neoRmtTiming(counter_clk_hz, is800KHz);
 
     // Initialize automatic timing translator
     rmt_translator_init(config.channel, ws2812_rmt_adapter);
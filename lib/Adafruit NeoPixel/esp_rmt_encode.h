@@ -0,0 +1,73 @@
+// WS2812/WS2811 bit timing and the byte-to-RMT-item encoder used by esp.c.
+// Plain C without ESP-IDF dependencies, so the exact encoder that runs on
+// the device can also be built and checked on a host (tools/ws2812emu.cpp).
+
+#ifndef ESP_RMT_ENCODE_H
+#define ESP_RMT_ENCODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WS2812_T0H_NS (400)
+#define WS2812_T0L_NS (850)
+#define WS2812_T1H_NS (800)
+#define WS2812_T1L_NS (450)
+
+#define WS2811_T0H_NS (500)
+#define WS2811_T0L_NS (2000)
+#define WS2811_T1H_NS (1200)
+#define WS2811_T1L_NS (1300)
+
+// One RMT item packed as the hardware (and rmt_item32_t.val) expects it:
+// duration0 in bits 0-14, level0 in bit 15, duration1 in 16-30, level1 in 31.
+#define NEO_RMT_ITEM(high, low) \
+  ((uint32_t)(high) | (1u << 15) | ((uint32_t)(low) << 16))
+
+typedef struct {
+  uint32_t bit0; // Item for a logical 0
+  uint32_t bit1; // Item for a logical 1
+} neo_rmt_timing_t;
+
+// Items for the given RMT counter clock. Same float conversion the driver
+// has always used, so tick counts are unchanged.
+static inline neo_rmt_timing_t neoRmtTiming(uint32_t counter_clk_hz,
+                                            bool is800KHz) {
+  float ratio = (float)counter_clk_hz / 1e9;
+  neo_rmt_timing_t t;
+  if (is800KHz) {
+    t.bit0 = NEO_RMT_ITEM((uint32_t)(ratio * WS2812_T0H_NS),
+                          (uint32_t)(ratio * WS2812_T0L_NS));
+    t.bit1 = NEO_RMT_ITEM((uint32_t)(ratio * WS2812_T1H_NS),
+                          (uint32_t)(ratio * WS2812_T1L_NS));
+  } else {
+    t.bit0 = NEO_RMT_ITEM((uint32_t)(ratio * WS2811_T0H_NS),
+                          (uint32_t)(ratio * WS2811_T0L_NS));
+    t.bit1 = NEO_RMT_ITEM((uint32_t)(ratio * WS2811_T1H_NS),
+                          (uint32_t)(ratio * WS2811_T1L_NS));
+  }
+  return t;
+}
+
+// Encodes whole bytes, MSB first, until 'src_size' bytes are done or fewer
+// than 8 of 'wanted_num' items are left. Returns the items written and
+// stores the bytes consumed in '*translated_size'. Branch-free per bit, as
+// it runs from the RMT interrupt on IDF 4.
+static inline __attribute__((always_inline)) size_t
+neoRmtEncode(const uint8_t *src, size_t src_size, uint32_t *dest,
+             size_t wanted_num, const neo_rmt_timing_t *t,
+             size_t *translated_size) {
+  const uint32_t bit0 = t->bit0, diff = t->bit0 ^ t->bit1;
+  size_t size = 0;
+  size_t num = 0;
+  while (size < src_size && num + 8 <= wanted_num) {
+    uint32_t byte = src[size++];
+    for (int i = 7; i >= 0; i--)
+      *dest++ = bit0 ^ (diff & (0u - ((byte >> i) & 1)));
+    num += 8;
+  }
+  *translated_size = size;
+  return num;
+}
+
+#endif // ESP_RMT_ENCODE_H
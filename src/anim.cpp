@@ -0,0 +1,122 @@
+#include "anim.h"
+#include <string.h>
+
+static const AnimFileHeader* fileHeader(const uint8_t* data) { return (const AnimFileHeader*)data; }
+static const AnimClipEntry* clipEntries(const uint8_t* data) { return (const AnimClipEntry*)(data + sizeof(AnimFileHeader)); }
+
+bool animValid(const uint8_t* data, size_t size) {
+  if (!data || size < sizeof(AnimFileHeader)) { return false; }
+  const AnimFileHeader* file = fileHeader(data);
+  if (file->magic != ANIM_MAGIC || file->version != ANIM_VERSION || file->totalSize > size) { return false; }
+  size = file->totalSize;
+  if (sizeof(AnimFileHeader) + (uint64_t)file->clipCount * sizeof(AnimClipEntry) > size) { return false; }
+  for (uint16_t c = 0; c < file->clipCount; c++) {
+    const AnimClipEntry& entry = clipEntries(data)[c];
+    if ((entry.offset & 3) || (uint64_t)entry.offset + entry.size > size) { return false; }
+    if (entry.size < sizeof(AnimClipHeader)) { return false; }
+    const AnimClipHeader* clip = (const AnimClipHeader*)(data + entry.offset);
+    if (clip->fps == 0 || clip->segmentCount > ANIM_MAX_SEGMENTS) { return false; }
+    uint32_t index = sizeof(AnimClipHeader) + (clip->frameCount + 1) * sizeof(uint32_t);
+    if (index > entry.size) { return false; }
+    const uint32_t* offsets = (const uint32_t*)(clip + 1);
+    if (offsets[0] != index || offsets[clip->frameCount] > entry.size) { return false; }
+    for (uint16_t f = 0; f < clip->frameCount; f++) {
+      if (offsets[f + 1] < offsets[f]) { return false; }
+    }
+  }
+  return true;
+}
+
+uint16_t animClipCount(const uint8_t* data) {
+  return data ? fileHeader(data)->clipCount : 0;
+}
+
+const char* animClipName(const uint8_t* data, uint16_t index) {
+  return clipEntries(data)[index].name;
+}
+
+bool animFind(const uint8_t* data, const char* name, AnimClip& clip) {
+  for (uint16_t c = 0; c < animClipCount(data); c++) {
+    const AnimClipEntry& entry = clipEntries(data)[c];
+    if (strncmp(entry.name, name, ANIM_NAME_LEN) != 0) { continue; }
+    clip.base = data + entry.offset;
+    clip.header = (const AnimClipHeader*)clip.base;
+    clip.frameOffsets = (const uint32_t*)(clip.header + 1);
+    return true;
+  }
+  return false;
+}
+
+void animFrame(const AnimClip& clip, uint16_t index, const uint8_t*& ops, uint32_t& size) {
+  ops = clip.base + clip.frameOffsets[index];
+  size = clip.frameOffsets[index + 1] - clip.frameOffsets[index];
+}
+
+// Frames address pixels across the whole canvas, so a clip made for other
+// strip lengths would put its pixels on the wrong strips.
+bool animLayoutMatches(const AnimClip& clip, const uint16_t* counts, uint8_t segments) {
+  if (clip.header->segmentCount != segments) { return false; }
+  for (uint8_t s = 0; s < segments; s++) {
+    if (clip.header->segments[s] != counts[s]) { return false; }
+  }
+  return true;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "pixel_delta.h"
+
+#define ANIM_PARTITION_SUBTYPE 0x40  // Custom data subtype, see partitions.csv
+
+static const uint8_t* mapped = nullptr;
+static spi_flash_mmap_handle_t mapHandle;
+
+bool animBegin() {
+  const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+      (esp_partition_subtype_t)ANIM_PARTITION_SUBTYPE, ANIM_PARTITION_NAME);
+  if (!part) { return false; }
+  AnimFileHeader file;
+  if (esp_partition_read(part, 0, &file, sizeof(file)) != ESP_OK) { return false; }
+  if (file.magic != ANIM_MAGIC || file.totalSize > part->size) { return false; } // Erased or foreign data
+  // Only the used part is mapped; the data cache window is shared with the
+  // app's constants, so a mostly empty partition costs nothing.
+  const void* ptr;
+  if (esp_partition_mmap(part, 0, file.totalSize, SPI_FLASH_MMAP_DATA, &ptr, &mapHandle) != ESP_OK) { return false; }
+  if (!animValid((const uint8_t*)ptr, file.totalSize)) {
+    spi_flash_munmap(mapHandle);
+    return false;
+  }
+  mapped = (const uint8_t*)ptr;
+  return true;
+}
+
+bool animOpen(const char* name, Canvas& canvas, AnimClip& clip) {
+  if (!mapped || !animFind(mapped, name, clip)) { return false; }
+  uint16_t counts[CANVAS_MAX_SEGMENTS];
+  for (uint8_t s = 0; s < canvas.segmentCount(); s++) { counts[s] = canvas.segment(s).numPixels(); }
+  if (animLayoutMatches(clip, counts, canvas.segmentCount())) { return true; }
+  Serial.printf("Animation %.16s was made for another strip layout, not played\n", name);
+  return false;
+}
+
+const uint8_t* animData() {
+  return mapped;
+}
+
+bool animApply(Canvas& canvas, const AnimClip& clip, int32_t from, uint16_t to) {
+  if (to >= clip.header->frameCount) { return false; }
+  if (from == (int32_t)to) { return true; }  // Already there
+  if (from < 0 || from > (int32_t)to) {
+    canvas.clear();
+    from = -1;
+  }
+  for (uint16_t f = from + 1; f <= to; f++) {
+    const uint8_t* ops;
+    uint32_t size;
+    animFrame(clip, f, ops, size);
+    if (!pixelDeltaApply(canvas, ops, size)) { return false; } // Clip is larger than the canvas
+  }
+  return true;
+}
+#endif
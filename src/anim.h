@@ -0,0 +1,82 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Container for pre-rendered animations, stored in the "anim" flash
+// partition and played straight from memory-mapped flash. All fields are
+// little-endian, like the ESP32 and the hosts that build the file.
+//
+//   AnimFileHeader
+//   AnimClipEntry[clipCount]
+//   per clip (4-byte aligned):
+//     AnimClipHeader
+//     uint32_t frameOffsets[frameCount + 1]  (from the clip header, last = end)
+//     frames, each a pixel_delta op stream against the previous frame
+//     (the first against black)
+//
+// Frames reuse the /pixels/delta encoding, so a player only applies ops and
+// never holds a decoded frame of its own.
+#define ANIM_MAGIC          0x41474342  // "BCGA"
+#define ANIM_VERSION        1
+#define ANIM_NAME_LEN       16
+#define ANIM_MAX_SEGMENTS   8
+#define ANIM_PARTITION_NAME "anim"
+
+struct AnimFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t clipCount;
+  uint32_t totalSize;     // Bytes used from the start of the container
+};
+
+struct AnimClipEntry {
+  char     name[ANIM_NAME_LEN]; // NUL padded
+  uint32_t offset;              // Clip header, from the start of the container
+  uint32_t size;                // Clip header up to the end of its last frame
+};
+
+struct AnimClipHeader {
+  uint16_t frameCount;
+  uint16_t numPixels;
+  uint8_t  fps;
+  uint8_t  segmentCount;
+  uint16_t segments[ANIM_MAX_SEGMENTS]; // Pixels per strip the clip was rendered for
+  uint16_t reserved;
+};
+
+static_assert(sizeof(AnimFileHeader) == 12, "AnimFileHeader layout");
+static_assert(sizeof(AnimClipEntry) == 24, "AnimClipEntry layout");
+static_assert(sizeof(AnimClipHeader) == 24, "AnimClipHeader layout");
+
+// A clip inside a mapped container. Points into the container, nothing is copied.
+struct AnimClip {
+  const AnimClipHeader* header;
+  const uint32_t* frameOffsets;
+  const uint8_t* base;           // Start of the clip header
+};
+
+// Checks the header and every clip's bounds and frame index.
+bool animValid(const uint8_t* data, size_t size);
+uint16_t animClipCount(const uint8_t* data);
+const char* animClipName(const uint8_t* data, uint16_t index);
+bool animFind(const uint8_t* data, const char* name, AnimClip& clip);
+void animFrame(const AnimClip& clip, uint16_t index, const uint8_t*& ops, uint32_t& size);
+// True if the clip was rendered for strips of these lengths, in this order.
+bool animLayoutMatches(const AnimClip& clip, const uint16_t* counts, uint8_t segments);
+
+#ifdef ARDUINO
+#include "canvas.h"
+
+bool animBegin();                                // Maps the partition, false if absent or invalid
+bool animOpen(const char* name, Canvas& canvas, AnimClip& clip); // False if absent or made for another layout
+const uint8_t* animData();                       // Mapped container, nullptr before animBegin()
+
+// Brings the canvas from frame `from` to frame `to` of the clip. Frames are
+// deltas, so every frame in between is applied; going backwards restarts
+// from a cleared canvas. Pass from = -1 for the first frame.
+bool animApply(Canvas& canvas, const AnimClip& clip, int32_t from, uint16_t to);
+#endif
+
+#endif
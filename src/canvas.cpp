@@ -0,0 +1,165 @@
+#include "canvas.h"
+
+bool Canvas::addSegment(int16_t pin, uint16_t count, neoPixelType type) {
+  if (segments >= CANVAS_MAX_SEGMENTS || framebuffer) { return false; } // Layout is fixed once begun
+  strips[segments] = new Adafruit_NeoPixel(0, pin, type);
+  starts[segments] = totalPixels;
+  counts[segments] = count;
+  types[segments] = type;
+  totalPixels += count;
+  segments++;
+  return true;
+}
+
+bool Canvas::addClockedSegment(int16_t dataPin, int16_t clockPin, uint16_t count) {
+  if (segments >= CANVAS_MAX_SEGMENTS || framebuffer) { return false; }
+  clocked[segments] = new ClockedStrip(dataPin, clockPin);
+  strips[segments] = clocked[segments];
+  starts[segments] = totalPixels;
+  counts[segments] = count;
+  types[segments] = NEO_BGR;                // The chips' own byte order, sent as stored
+  totalPixels += count;
+  segments++;
+  return true;
+}
+
+static uint8_t bytesPerPixel(neoPixelType type) {
+  return (((type >> 6) & 3) == ((type >> 4) & 3)) ? 3 : 4; // W offset equals R offset on RGB strips
+}
+
+// Long strips get their buffers in PSRAM to keep internal RAM for the
+// network stack; the RMT driver stages each strip through internal RAM.
+uint8_t* canvasAlloc(size_t bytes) {
+#ifdef BOARD_HAS_PSRAM
+  if (bytes >= CANVAS_PSRAM_MIN_BYTES && psramFound()) {
+    uint8_t* p = (uint8_t*)ps_calloc(1, bytes);
+    if (p) { return p; }
+  }
+#endif
+  return (uint8_t*)calloc(1, bytes ? bytes : 1);
+}
+
+bool Canvas::begin() {
+  uint32_t bytes = 0;
+  for (uint8_t s = 0; s < segments; s++) { bytes += counts[s] * bytesPerPixel(types[s]); }
+  framebuffer = canvasAlloc(bytes);
+  if (!framebuffer) { return false; }
+  uint8_t* slice = framebuffer;
+  bool ok = true;
+  for (uint8_t s = 0; s < segments; s++) {
+    strips[s]->setPixelBuffer(slice, counts[s]); // Strip renders straight into its slice
+    if (clocked[s]) { ok &= clocked[s]->begin(); } // Out of SPI buses or memory: pixels kept, never sent
+    else { strips[s]->begin(); }
+    slice += counts[s] * bytesPerPixel(types[s]);
+  }
+  return ok;
+}
+
+uint8_t Canvas::findSegment(uint16_t i) const {
+  uint8_t s = 0;
+  while (s + 1 < segments && i >= starts[s + 1]) { s++; }
+  return s;
+}
+
+void Canvas::setPixel(uint16_t i, uint32_t c) {
+  if (i >= totalPixels) { return; }
+  uint8_t s = findSegment(i);
+  strips[s]->setPixelColor(i - starts[s], c);
+}
+
+uint32_t Canvas::getPixel(uint16_t i) const {
+  if (i >= totalPixels) { return 0; }
+  uint8_t s = findSegment(i);
+  return strips[s]->getPixelColor(i - starts[s]);
+}
+
+void Canvas::fill(uint32_t c, uint16_t first, uint16_t count) {
+  if (first >= totalPixels) { return; }
+  uint32_t end = count ? min<uint32_t>((uint32_t)first + count, totalPixels) : totalPixels;
+  for (uint8_t s = findSegment(first); s < segments && starts[s] < end; s++) {
+    uint16_t from = max(first, starts[s]) - starts[s];
+    uint16_t to = min<uint32_t>(end, starts[s] + counts[s]) - starts[s];
+    if (to > from) { strips[s]->fill(c, from, to - from); }
+  }
+}
+
+void Canvas::write(uint16_t first, const uint8_t* rgb, uint16_t count) {
+  if (first >= totalPixels) { return; }
+  uint32_t end = min<uint32_t>((uint32_t)first + count, totalPixels);
+  for (uint8_t s = findSegment(first); s < segments && starts[s] < end; s++) {
+    uint16_t from = max(first, starts[s]) - starts[s];
+    uint16_t to = min<uint32_t>(end, starts[s] + counts[s]) - starts[s];
+    Adafruit_NeoPixel* strip = strips[s];
+    const uint8_t* p = rgb + (starts[s] + from - first) * 3;
+    for (uint16_t i = from; i < to; i++, p += 3) { strip->setPixelColor(i, p[0], p[1], p[2]); }
+  }
+}
+
+// 16-bit values are reduced to 8.8 fixed point first: v - (v >> 8) maps
+// c * 257 to exactly c << 8, so full-scale and plain 8-bit colours have no
+// fraction and never flicker. With dithering on, the fraction left over is
+// added to the next frame, so a level between two steps alternates between
+// them at the right ratio instead of being rounded away.
+bool Canvas::write16(uint16_t first, const uint16_t* rgb, uint16_t count) {
+  if (first >= totalPixels) { return true; }
+  uint32_t end = min<uint32_t>((uint32_t)first + count, totalPixels);
+  uint8_t fraction = 0;
+  for (uint8_t s = findSegment(first); s < segments && starts[s] < end; s++) {
+    uint16_t from = max(first, starts[s]) - starts[s];
+    uint16_t to = min<uint32_t>(end, starts[s] + counts[s]) - starts[s];
+    Adafruit_NeoPixel* strip = strips[s];
+    const uint16_t* p = rgb + (starts[s] + from - first) * 3;
+    uint8_t* e = residual ? residual + (starts[s] + from) * 3 : nullptr;
+    for (uint16_t i = from; i < to; i++) {
+      uint8_t out[3];
+      for (uint8_t c = 0; c < 3; c++, p++) {
+        uint16_t t = *p - (*p >> 8);
+        fraction |= t;
+        if (e) {
+          uint16_t v = t + *e;
+          out[c] = v >> 8;
+          *e++ = v;
+        }
+        else { out[c] = (t + 128) >> 8; }
+      }
+      strip->setPixelColor(i, out[0], out[1], out[2]);
+    }
+  }
+  return (fraction & 0xFF) == 0;
+}
+
+bool Canvas::setDither(bool on) {
+  if (!on) {
+    free(residual);
+    residual = nullptr;
+    return true;
+  }
+  if (!residual) { residual = canvasAlloc(totalPixels * 3); }
+  return residual != nullptr;
+}
+
+void Canvas::clear() {
+  for (uint8_t s = 0; s < segments; s++) { strips[s]->clear(); }
+}
+
+// The strips keep their per-channel level sums as they are drawn, so the
+// estimate needs no pass over the pixels; effectsLockCanvas() keeps writers
+// and show() apart. Over budget, every strip is scaled by the same factor
+// while it is sent; the idle current of the pixels cannot be dimmed and is
+// left out of the factor.
+void Canvas::show() {
+  uint32_t total = 0, idle = 0;
+  for (uint8_t s = 0; s < segments; s++) {
+    total += strips[s]->estimateMilliamps();
+    idle += counts[s] * NEO_MA_IDLE;
+  }
+  uint16_t factor = 256;
+  if (budgetMa && total > budgetMa) { factor = budgetMa > idle ? (uint64_t)(budgetMa - idle) * 256 / (total - idle) : 0; }
+  for (uint8_t s = 0; s < segments; s++) {
+    strips[s]->setPowerScale(factor);   // Marks the strip dirty if the factor changed
+    if (clocked[s]) { clocked[s]->show(); }
+    else { strips[s]->show(); }         // Clean segments return at once
+  }
+  estimateMa = total;
+  scale = factor;
+}
@@ -0,0 +1,64 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <Adafruit_NeoPixel.h>
+#include "clocked_strip.h"
+
+#define CANVAS_MAX_SEGMENTS    8     // Physical strips one podium can drive
+#define CANVAS_PSRAM_MIN_BYTES 2048  // Buffers at least this big go to PSRAM when present
+
+// One contiguous wire-order framebuffer spanning several physical strips.
+// Each segment is a run of logical pixels mapped to one strip and pin; its
+// Adafruit_NeoPixel object renders into its slice of the shared buffer, so
+// there is no per-strip copy. Effects and OSC pixel commands address pixels
+// by logical index across all segments. Clocked (APA102/SK9822) segments
+// keep their pixels the same way and only differ in how show() sends them.
+// calloc() that prefers PSRAM for buffers of CANVAS_PSRAM_MIN_BYTES or more.
+uint8_t* canvasAlloc(size_t bytes);
+
+class Canvas {
+public:
+  bool addSegment(int16_t pin, uint16_t count, neoPixelType type = NEO_GRB + NEO_KHZ800);
+  bool addClockedSegment(int16_t dataPin, int16_t clockPin, uint16_t count);
+  bool begin();                             // Allocates the framebuffer and attaches the strips
+
+  uint16_t numPixels() const { return totalPixels; }
+  uint8_t segmentCount() const { return segments; }
+  Adafruit_NeoPixel& segment(uint8_t s) { return *strips[s]; }
+  ClockedStrip* clockedSegment(uint8_t s) const { return clocked[s]; } // nullptr on NeoPixel segments
+  uint16_t segmentStart(uint8_t s) const { return starts[s]; }
+  neoPixelType segmentType(uint8_t s) const { return types[s]; }
+
+  void setPixel(uint16_t i, uint32_t c);
+  uint32_t getPixel(uint16_t i) const;
+  void fill(uint32_t c, uint16_t first = 0, uint16_t count = 0); // count 0 = to the end
+  void write(uint16_t first, const uint8_t* rgb, uint16_t count); // R,G,B triplets
+  bool write16(uint16_t first, const uint16_t* rgb, uint16_t count); // 16-bit triplets, true if exact in 8 bits
+  bool setDither(bool on);                  // Temporal dithering of write16() output
+  bool dithering() const { return residual != nullptr; }
+  void clear();
+  void show();                              // Pushes every dirty segment in one pass
+
+  void setPowerBudget(uint32_t mA) { budgetMa = mA; } // 0 = unlimited
+  uint32_t powerBudget() const { return budgetMa; }
+  uint32_t estimateMilliamps() const { return estimateMa; } // Unlimited draw at the last show()
+  uint16_t powerScale() const { return scale; }   // Applied at the last show(), 256 = full
+
+private:
+  uint8_t findSegment(uint16_t i) const;
+
+  Adafruit_NeoPixel* strips[CANVAS_MAX_SEGMENTS];
+  ClockedStrip* clocked[CANVAS_MAX_SEGMENTS] = {}; // Same object as strips[s] on clocked segments
+  uint16_t starts[CANVAS_MAX_SEGMENTS];     // First logical pixel of each segment
+  uint16_t counts[CANVAS_MAX_SEGMENTS];
+  neoPixelType types[CANVAS_MAX_SEGMENTS];
+  uint8_t segments = 0;
+  uint16_t totalPixels = 0;
+  uint8_t* framebuffer = nullptr;
+  uint8_t* residual = nullptr;              // Per-channel error carried to the next frame
+  uint32_t budgetMa = 0;
+  uint32_t estimateMa = 0;
+  uint16_t scale = 256;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "clocked_strip.h"
+#include <string.h>
+
+void clockedEncode(const uint8_t* bgr, uint16_t numPixels, uint16_t scale, uint8_t* out) {
+  if (scale > 256) { scale = 256; }
+  // Smallest global brightness that still reaches the scale, then the colour
+  // bytes make up the rest: factor = scale * 31 / brightness is 248-256
+  // except at the very lowest levels.
+  uint8_t level = (scale * CLOCKED_MAX_BRIGHTNESS + 255) >> 8;
+  uint16_t factor = level ? scale * CLOCKED_MAX_BRIGHTNESS / level : 0;
+  memset(out, 0, 4);
+  out += 4;
+  uint8_t header = 0xE0 | level;
+  if (factor == 256) {
+    for (uint16_t i = 0; i < numPixels; i++, bgr += 3, out += 4) {
+      out[0] = header;
+      out[1] = bgr[0];
+      out[2] = bgr[1];
+      out[3] = bgr[2];
+    }
+  } else {
+    for (uint16_t i = 0; i < numPixels; i++, bgr += 3, out += 4) {
+      out[0] = header;
+      out[1] = (bgr[0] * factor) >> 8;
+      out[2] = (bgr[1] * factor) >> 8;
+      out[3] = (bgr[2] * factor) >> 8;
+    }
+  }
+  memset(out, 0, 4 + (numPixels + 15) / 16);
+}
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+
+static uint8_t busesUsed = 0;
+static const uint8_t BUSES[CLOCKED_MAX_BUSES] = {HSPI, VSPI};
+
+ClockedStrip::ClockedStrip(int16_t d, int16_t c, uint32_t h)
+    : Adafruit_NeoPixel(0, -1, NEO_BGR), dataPin(d), clockPin(c), hz(h) {}
+
+ClockedStrip::~ClockedStrip() {
+  delete device;
+  delete bus;
+  heap_caps_free(frame);
+}
+
+bool ClockedStrip::begin() {
+  Adafruit_NeoPixel::begin();                    // No pin of its own, only marks the strip begun
+  if (device) { return true; }
+  if (busesUsed >= CLOCKED_MAX_BUSES || dataPin < 0 || clockPin < 0) { return false; }
+  frameBytes = clockedFrameBytes(numLEDs);
+  frame = (uint8_t*)heap_caps_malloc(frameBytes, MALLOC_CAP_DMA);
+  if (!frame) { return false; }
+  bus = new SPIClass(BUSES[busesUsed++]);
+  bus->begin(clockPin, -1, dataPin, -1);         // Adafruit_SPIDevice::begin() keeps these pins
+  device = new Adafruit_SPIDevice(-1, hz, SPI_BITORDER_MSBFIRST, SPI_MODE0, bus);
+  return device->begin();
+}
+
+void ClockedStrip::show() {
+  if (!pixels || !device || !dirty) { return; }
+  dirty = false;                                 // Before encoding: a write made meanwhile goes out next time
+  clockedEncode(pixels, numLEDs, powerScale, frame);
+  uint32_t start = micros();
+  device->write(frame, frameBytes);              // One transfer, no chip select
+  frameUs = micros() - start;
+}
+#endif
@@ -0,0 +1,59 @@
+#ifndef CLOCKED_STRIP_H
+#define CLOCKED_STRIP_H
+
+#include <stdint.h>
+
+// APA102 / SK9822 strips: separate data and clock lines, so the frame is a
+// plain SPI transfer at tens of MHz instead of a timed 800 kHz waveform.
+// One SPI frame for n pixels:
+//   start frame   4 x 0x00
+//   per pixel     0xE0 | brightness (5 bits), B, G, R
+//   end frame     4 x 0x00, then (n + 15) / 16 x 0x00
+// The first four zero bytes of the end frame are the SK9822 latch; the rest
+// are the n/2 extra clock edges APA102 chains need, as every pixel delays
+// the data by half a clock. Zeros never look like a pixel header, so the
+// same frame drives both chips.
+#define CLOCKED_DEFAULT_HZ     20000000  // Fine for a few metres of cable; the chips take up to ~30 MHz
+#define CLOCKED_MAX_BRIGHTNESS 31
+
+static inline uint32_t clockedFrameBytes(uint16_t numPixels) {
+  return 4 + (uint32_t)numPixels * 4 + 4 + (numPixels + 15) / 16;
+}
+
+// Encodes pixels stored in B,G,R order (NEO_BGR, the chip's own order)
+// into a frame of clockedFrameBytes() bytes. `scale` is the power scale
+// 0-256 from Adafruit_NeoPixel::setPowerScale(): it goes into the 5-bit
+// global brightness first and only the remainder into the colour bytes,
+// so a dimmed strip keeps nearly all of its 8-bit steps.
+void clockedEncode(const uint8_t* bgr, uint16_t numPixels, uint16_t scale, uint8_t* out);
+
+#ifdef ARDUINO
+#include <Adafruit_NeoPixel.h>
+#include <Adafruit_SPIDevice.h>
+
+#define CLOCKED_MAX_BUSES 2  // HSPI and VSPI; SPI0/1 belong to flash and PSRAM
+
+// Pixel storage, brightness, level sums and the power scale are inherited,
+// so the canvas and effects treat it like any other strip. Only begin() and
+// show() differ; call them on the ClockedStrip, not through the base class.
+class ClockedStrip : public Adafruit_NeoPixel {
+public:
+  ClockedStrip(int16_t dataPin, int16_t clockPin, uint32_t hz = CLOCKED_DEFAULT_HZ);
+  ~ClockedStrip();
+
+  bool begin();  // Claims an SPI bus and the frame buffer, after setPixelBuffer()
+  void show();   // Encodes and sends the frame if the pixels changed
+  uint32_t frameMicros() const { return frameUs; } // Duration of the last transfer
+
+private:
+  int16_t dataPin, clockPin;
+  uint32_t hz;
+  SPIClass* bus = nullptr;
+  Adafruit_SPIDevice* device = nullptr;
+  uint8_t* frame = nullptr;   // Internal RAM, so the SPI driver can read it directly
+  uint32_t frameBytes = 0;
+  uint32_t frameUs = 0;
+};
+#endif
+
+#endif
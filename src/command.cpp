@@ -0,0 +1,119 @@
+#include "command.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static inline char upper(char c) { return (c >= 'a' && c <= 'z') ? c - 32 : c; }
+
+static bool sameName(const char* name, const char* text, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (!name[i] || upper(name[i]) != upper(text[i])) { return false; }
+  }
+  return name[length] == '\0';
+}
+
+CommandResult commandRun(const Command* table, uint8_t count, const char* line, size_t length, CommandReply& reply) {
+  const char* p = line;
+  const char* end = line + length;
+  while (p < end && isSpace(*p)) { p++; }
+  const char* name = p;
+  uint32_t hash = 2166136261u;
+  while (p < end && !isSpace(*p)) { hash = commandHashStep(hash, *p++); }
+  size_t nameLength = p - name;
+  if (nameLength == 0) { return COMMAND_EMPTY; }
+  const Command* command = nullptr;
+  for (uint8_t i = 0; i < count && !command; i++) {
+    if (table[i].hash == hash && sameName(table[i].name, name, nameLength)) { command = &table[i]; }
+  }
+  if (!command) {
+    commandPrintf(reply, "❌ Unknown command %.*s, send HELP for the list.\n", (int)nameLength, name);
+    return COMMAND_UNKNOWN;
+  }
+  CommandArgs args;
+  args.count = 0;
+  bool tooMany = false;
+  for (;;) {
+    while (p < end && isSpace(*p)) { p++; }
+    if (p == end) { break; }
+    const char* arg = p;
+    while (p < end && !isSpace(*p)) { p++; }
+    if (args.count == COMMAND_MAX_ARGS || p - arg > 255) { tooMany = true; break; }
+    args.text[args.count] = arg;
+    args.length[args.count++] = p - arg;
+  }
+  if (tooMany || args.count < command->minArgs || args.count > command->maxArgs) {
+    commandPrintf(reply, "❌ Usage: %s %s\n", command->name, command->usage);
+    return COMMAND_USAGE;
+  }
+  command->handler(args, reply);
+  return COMMAND_OK;
+}
+
+void commandHelp(const Command* table, uint8_t count, CommandReply& reply) {
+  commandPrint(reply, "Available commands:\n");
+  for (uint8_t i = 0; i < count; i++) {
+    commandPrintf(reply, "%s%s%s - %s\n", table[i].name, table[i].usage[0] ? " " : "", table[i].usage, table[i].help);
+  }
+}
+
+void commandPrint(CommandReply& reply, const char* text) {
+  reply.write(reply.context, text, strlen(text));
+}
+
+void commandPrintf(CommandReply& reply, const char* format, ...) {
+  char text[COMMAND_REPLY_SIZE];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) { return; }
+  reply.write(reply.context, text, (size_t)length < sizeof(text) ? length : sizeof(text) - 1);
+}
+
+bool commandArgIs(const CommandArgs& args, uint8_t index, const char* word) {
+  return index < args.count && sameName(word, args.text[index], args.length[index]);
+}
+
+bool commandArgInt(const CommandArgs& args, uint8_t index, long min, long max, long& value) {
+  return index < args.count && commandParseInt(args.text[index], args.length[index], min, max, value);
+}
+
+bool commandArgIp(const CommandArgs& args, uint8_t index, uint8_t address[4]) {
+  return index < args.count && commandParseIp(args.text[index], args.length[index], address);
+}
+
+bool commandParseInt(const char* text, size_t length, long min, long max, long& value) {
+  const char* p = text;
+  const char* end = text + length;
+  bool negative = p < end && *p == '-';
+  if (p < end && (negative || *p == '+')) { p++; }
+  if (p == end) { return false; }
+  long v = 0;
+  for (; p < end; p++) {
+    if (*p < '0' || *p > '9') { return false; }
+    v = v * 10 + (*p - '0');
+    if (v > 1000000000L) { return false; } // Far outside any range used, and no overflow
+  }
+  if (negative) { v = -v; }
+  if (v < min || v > max) { return false; }
+  value = v;
+  return true;
+}
+
+bool commandParseIp(const char* text, size_t length, uint8_t address[4]) {
+  const char* p = text;
+  const char* end = text + length;
+  uint8_t octets[4];
+  for (uint8_t i = 0; i < 4; i++) {
+    if (i > 0 && (p == end || *p++ != '.')) { return false; }
+    uint16_t v = 0;
+    uint8_t digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9' && digits < 3; p++, digits++) { v = v * 10 + (*p - '0'); }
+    if (digits == 0 || v > 255) { return false; }
+    octets[i] = v;
+  }
+  if (p != end) { return false; }
+  memcpy(address, octets, 4);
+  return true;
+}
@@ -0,0 +1,68 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Text commands ("SET_IP 192.168.1.50") from Bluetooth, USB serial and OSC
+// "/command", all run from one table. A line is split in place: arguments
+// are spans of the caller's buffer, numbers and addresses are parsed from
+// those spans, and the name is found by comparing its hash before the text.
+// Nothing is copied or allocated. Names are not case sensitive. Replies go
+// to whichever transport the line came from.
+#define COMMAND_MAX_ARGS   6
+#define COMMAND_REPLY_SIZE 192   // Longest single formatted reply
+
+struct CommandArgs {
+  uint8_t     count;
+  const char* text[COMMAND_MAX_ARGS];   // Not NUL-terminated
+  uint8_t     length[COMMAND_MAX_ARGS];
+};
+
+struct CommandReply {
+  void (*write)(void* context, const char* text, size_t length);
+  void* context;
+};
+
+typedef void (*CommandHandler)(const CommandArgs& args, CommandReply& reply);
+
+struct Command {
+  uint32_t       hash;                  // commandHash(name)
+  const char*    name;
+  uint8_t        minArgs, maxArgs;
+  CommandHandler handler;
+  const char*    usage;                 // Arguments, for HELP and a wrong argument count
+  const char*    help;
+};
+
+// FNV-1a over the upper-cased name, so the table's hashes are compile-time constants.
+constexpr uint32_t commandHashStep(uint32_t hash, char c) {
+  return (hash ^ (uint8_t)(c >= 'a' && c <= 'z' ? c - 32 : c)) * 16777619u;
+}
+constexpr uint32_t commandHash(const char* name, uint32_t hash = 2166136261u) {
+  return *name ? commandHash(name + 1, commandHashStep(hash, *name)) : hash;
+}
+#define COMMAND(name, minArgs, maxArgs, handler, usage, help) \
+  { commandHash(name), name, minArgs, maxArgs, handler, usage, help }
+
+enum CommandResult : uint8_t { COMMAND_OK, COMMAND_EMPTY, COMMAND_UNKNOWN, COMMAND_USAGE };
+
+// Runs one line of `length` bytes, without its terminator. Unknown names and
+// wrong argument counts are answered here, everything else by the handler.
+CommandResult commandRun(const Command* table, uint8_t count, const char* line, size_t length, CommandReply& reply);
+void commandHelp(const Command* table, uint8_t count, CommandReply& reply);
+
+void commandPrint(CommandReply& reply, const char* text);
+void commandPrintf(CommandReply& reply, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// Argument parsers. Each accepts the whole span or nothing, so "12abc" is
+// not 12. False if the argument is missing, malformed or out of range.
+bool commandArgIs(const CommandArgs& args, uint8_t index, const char* word);
+bool commandArgInt(const CommandArgs& args, uint8_t index, long min, long max, long& value);
+bool commandArgIp(const CommandArgs& args, uint8_t index, uint8_t address[4]);
+
+// The same parsers on any span, for values that did not come from a line.
+bool commandParseInt(const char* text, size_t length, long min, long max, long& value);
+bool commandParseIp(const char* text, size_t length, uint8_t address[4]);
+
+#endif
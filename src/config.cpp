@@ -0,0 +1,187 @@
+#include "config.h"
+#include "command.h"
+#include "dmx.h"
+#include <string.h>
+
+#define CONFIG_HEADER_SIZE 8  // version, size, crc
+
+uint32_t configCrc32(const uint8_t* data, size_t size) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (size--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++) { crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1))); }
+  }
+  return ~crc;
+}
+
+void configSeal(DeviceConfig& config) {
+  config.version = CONFIG_VERSION;
+  config.size = sizeof(DeviceConfig);
+  config.crc = configCrc32((const uint8_t*)&config + CONFIG_HEADER_SIZE, sizeof(DeviceConfig) - CONFIG_HEADER_SIZE);
+}
+
+bool configDecode(const uint8_t* data, size_t size, DeviceConfig& config) {
+  if (size < CONFIG_HEADER_SIZE) { return false; }
+  DeviceConfig header;
+  memcpy(&header, data, CONFIG_HEADER_SIZE);
+  if (header.version == 0 || header.size < CONFIG_HEADER_SIZE || header.size > size) { return false; }
+  if (configCrc32(data + CONFIG_HEADER_SIZE, header.size - CONFIG_HEADER_SIZE) != header.crc) { return false; }
+  memcpy(&config, data, header.size < sizeof(DeviceConfig) ? header.size : sizeof(DeviceConfig));
+  configSeal(config);                    // Now a record of this version
+  return true;
+}
+
+#define FIELD(name, type, member, min, max) \
+  { name, type, (uint8_t)offsetof(DeviceConfig, member), (uint8_t)sizeof(((DeviceConfig*)0)->member), min, max }
+#define STRIP_FIELDS(n) \
+  FIELD("strip" #n "Pin",   CONFIG_FIELD_INT, strips[n - 1].pin,   -1, 39), \
+  FIELD("strip" #n "Count", CONFIG_FIELD_INT, strips[n - 1].count,  0, 65535), \
+  FIELD("strip" #n "Clock", CONFIG_FIELD_INT, strips[n - 1].clock, -1, 39)
+
+const ConfigField CONFIG_FIELDS[] = {
+  FIELD("id",          CONFIG_FIELD_INT, deviceId,    1, 8),
+  FIELD("ip",          CONFIG_FIELD_IP,  ip,          0, 0),
+  FIELD("subnet",      CONFIG_FIELD_IP,  subnet,      0, 0),
+  FIELD("gateway",     CONFIG_FIELD_IP,  gateway,     0, 0),
+  FIELD("dhcp",        CONFIG_FIELD_INT, dhcp,        0, 1),
+  FIELD("outIp",       CONFIG_FIELD_IP,  outIp,       0, 0),
+  FIELD("inPort",      CONFIG_FIELD_INT, inPort,      1, 65535),
+  FIELD("outPort",     CONFIG_FIELD_INT, outPort,     1, 65535),
+  FIELD("dmx",         CONFIG_FIELD_DMX, dmxProtocol, DMX_OFF, DMX_SACN),
+  FIELD("dmxUniverse", CONFIG_FIELD_INT, dmxUniverse, 0, 32767),
+  FIELD("dmxStart",    CONFIG_FIELD_INT, dmxStart,    1, DMX_SLOTS),
+  FIELD("dither",      CONFIG_FIELD_INT, dither,      0, 1),
+  FIELD("powerMa",     CONFIG_FIELD_INT, powerMa,     0, 100000),
+  FIELD("btWindow",    CONFIG_FIELD_INT, btWindow,    0, 65535),
+  STRIP_FIELDS(1), STRIP_FIELDS(2), STRIP_FIELDS(3), STRIP_FIELDS(4),
+};
+const uint8_t CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+static_assert(CONFIG_MAX_STRIPS == 4, "One STRIP_FIELDS line per strip");
+
+const ConfigField* configField(const char* name, size_t length) {
+  for (uint8_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (strlen(CONFIG_FIELDS[i].name) == length && !strncmp(CONFIG_FIELDS[i].name, name, length)) { return &CONFIG_FIELDS[i]; }
+  }
+  return nullptr;
+}
+
+int32_t configFieldGet(const DeviceConfig& config, const ConfigField& field) {
+  int32_t value = 0;
+  memcpy(&value, (const uint8_t*)&config + field.offset, field.size); // Little-endian, as on the ESP32
+  if (field.min < 0 && field.size == 1) { value = (int8_t)value; }
+  return value;
+}
+
+const uint8_t* configFieldIp(const DeviceConfig& config, const ConfigField& field) {
+  return (const uint8_t*)&config + field.offset;
+}
+
+bool configFieldSet(DeviceConfig& config, const ConfigField& field, int32_t value) {
+  if (field.type == CONFIG_FIELD_IP || value < field.min || value > field.max) { return false; }
+  memcpy((uint8_t*)&config + field.offset, &value, field.size);
+  return true;
+}
+
+bool configFieldSetText(DeviceConfig& config, const ConfigField& field, const char* text, size_t length) {
+  if (field.type == CONFIG_FIELD_IP) { return commandParseIp(text, length, (uint8_t*)&config + field.offset); }
+  if (field.type == CONFIG_FIELD_DMX) {
+    for (int32_t protocol = field.min; protocol <= field.max; protocol++) {
+      const char* name = dmxProtocolName(protocol);
+      if (strlen(name) == length && !strncmp(name, text, length)) { return configFieldSet(config, field, protocol); }
+    }
+  }
+  long value;
+  return commandParseInt(text, length, field.min, field.max, value) && configFieldSet(config, field, value);
+}
+
+#ifdef ARDUINO
+#include <Preferences.h>
+
+static DeviceConfig stored;             // Last record read or written, to skip unchanged writes
+static bool storedValid = false;
+
+static void readIPAddress(Preferences& prefs, const char* prefix, uint8_t* address) {
+  char key[8];
+  for (uint8_t i = 0; i < 4; i++) {
+    snprintf(key, sizeof(key), "%s%u", prefix, i);
+    address[i] = prefs.getUInt(key, address[i]);
+  }
+}
+
+// Keys written by firmware before the blob, one per value.
+static bool readOldKeys(Preferences& prefs, DeviceConfig& config) {
+  if (!prefs.isKey("device_id") && !prefs.isKey("ip0") && !prefs.isKey("pin1")) { return false; }
+  config.deviceId = prefs.getUInt("device_id", config.deviceId);
+  readIPAddress(prefs, "ip", config.ip);
+  readIPAddress(prefs, "sub", config.subnet);
+  readIPAddress(prefs, "gw", config.gateway);
+  readIPAddress(prefs, "out", config.outIp);
+  config.inPort      = prefs.getUInt("inPort", config.inPort);
+  config.outPort     = prefs.getUInt("outPort", config.outPort);
+  config.dmxProtocol = prefs.getUInt("dmxMode", config.dmxProtocol);
+  config.dmxUniverse = prefs.getUInt("dmxUni", config.dmxUniverse);
+  config.dmxStart    = prefs.getUInt("dmxStart", config.dmxStart);
+  config.dither      = prefs.getBool("dither", config.dither);
+  config.powerMa     = prefs.getUInt("powerMa", config.powerMa);
+  char key[8];
+  for (uint8_t s = 0; s < CONFIG_MAX_STRIPS; s++) {
+    snprintf(key, sizeof(key), "pin%u", s + 1);
+    config.strips[s].pin = prefs.getInt(key, config.strips[s].pin);
+    snprintf(key, sizeof(key), "len%u", s + 1);
+    config.strips[s].count = prefs.getUInt(key, config.strips[s].count);
+    snprintf(key, sizeof(key), "clk%u", s + 1);
+    config.strips[s].clock = prefs.getInt(key, config.strips[s].clock);
+  }
+  return true;
+}
+
+static void removeOldKeys(Preferences& prefs) {
+  static const char* const KEYS[] = { "device_id", "inPort", "outPort", "dmxMode", "dmxUni", "dmxStart", "dither", "powerMa" };
+  static const char* const PREFIXES[] = { "ip", "sub", "gw", "out", "pin", "len", "clk" };
+  char key[8];
+  for (const char* k : KEYS) { prefs.remove(k); }
+  for (const char* p : PREFIXES) {
+    for (uint8_t i = 0; i <= 4; i++) {              // Octets 0-3, strips 1-4
+      snprintf(key, sizeof(key), "%s%u", p, i);
+      prefs.remove(key);
+    }
+  }
+}
+
+ConfigSource configLoad(DeviceConfig& config) {
+  Preferences prefs;
+  uint8_t blob[CONFIG_BLOB_MAX];
+  prefs.begin(CONFIG_NAMESPACE, true);
+  size_t size = prefs.getBytes(CONFIG_KEY, blob, sizeof(blob));
+  bool found = size && configDecode(blob, size, config);
+  bool migrate = !found && readOldKeys(prefs, config);
+  prefs.end();
+  configSeal(config);
+  if (found) {
+    stored = config;
+    storedValid = true;
+    return CONFIG_FROM_BLOB;
+  }
+  if (!migrate) { return CONFIG_FROM_DEFAULTS; } // Nothing stored yet, written on the first change
+  if (configSave(config)) {
+    prefs.begin(CONFIG_NAMESPACE, false);
+    removeOldKeys(prefs);                          // Only once the blob is safely written
+    prefs.end();
+  }
+  return CONFIG_FROM_KEYS;
+}
+
+bool configSave(DeviceConfig& config) {
+  configSeal(config);
+  if (storedValid && memcmp(&stored, &config, sizeof(config)) == 0) { return true; }
+  Preferences prefs;
+  if (!prefs.begin(CONFIG_NAMESPACE, false)) { return false; }
+  bool ok = prefs.putBytes(CONFIG_KEY, &config, sizeof(config)) == sizeof(config);
+  prefs.end();
+  if (ok) {
+    stored = config;
+    storedValid = true;
+  }
+  return ok;
+}
+#endif
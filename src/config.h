@@ -0,0 +1,91 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// All persistent settings in one record, stored as a single NVS blob so boot
+// is one read and a change is one write. Fields are only ever appended: a
+// record from older firmware is shorter, and its missing fields keep their
+// defaults; a record from newer firmware is read as far as this one knows.
+// `size` is the stored length, and the CRC covers everything after the header.
+#define CONFIG_NAMESPACE   "CONFIG"
+#define CONFIG_KEY         "cfg"
+#define CONFIG_VERSION     3
+#define CONFIG_MAX_STRIPS  4
+#define CONFIG_BLOB_MAX    256   // Largest record accepted, leaves room for later fields
+
+struct ConfigStrip {
+  int8_t   pin;          // -1 = unused
+  int8_t   clock;        // >= 0 = APA102/SK9822 on SPI
+  uint16_t count;
+};
+
+struct DeviceConfig {
+  uint16_t version;      // CONFIG_VERSION that wrote it
+  uint16_t size;         // sizeof(DeviceConfig) of that version
+  uint32_t crc;          // CRC-32 of bytes 8 to size
+  uint8_t  deviceId;
+  uint8_t  dmxProtocol;
+  uint8_t  dither;
+  uint8_t  reserved;
+  uint8_t  ip[4];
+  uint8_t  subnet[4];
+  uint8_t  gateway[4];
+  uint8_t  outIp[4];
+  uint16_t inPort;
+  uint16_t outPort;
+  uint16_t dmxUniverse;
+  uint16_t dmxStart;
+  uint32_t powerMa;
+  ConfigStrip strips[CONFIG_MAX_STRIPS];
+  uint16_t btWindow;     // Version 2: seconds Bluetooth stays on after boot, 0 = always
+  uint16_t reserved2;
+  uint8_t  dhcp;         // Version 3: address by DHCP, ip/subnet/gateway as fallback
+  uint8_t  reserved3[3];
+  uint8_t  leaseIp[4];   // Last DHCP lease, 0.0.0.0 = none; not a field
+  uint8_t  leaseSubnet[4];
+  uint8_t  leaseGateway[4];
+};
+
+static_assert(sizeof(DeviceConfig) == 76, "DeviceConfig layout");
+
+uint32_t configCrc32(const uint8_t* data, size_t size);
+void configSeal(DeviceConfig& config);            // Sets version, size and CRC
+
+// Checks a stored record and copies what this version knows of it over
+// `config`, which should hold the defaults. False if the record is corrupt.
+bool configDecode(const uint8_t* data, size_t size, DeviceConfig& config);
+
+// Fields by name, for /config/get and /config/set: "id", "ip", "inPort",
+// "dmx", "strip1Pin", ... Each is range-checked on its own; whether the
+// strips work together is up to the caller.
+enum ConfigFieldType : uint8_t { CONFIG_FIELD_INT, CONFIG_FIELD_IP, CONFIG_FIELD_DMX };
+
+struct ConfigField {
+  const char*     name;
+  ConfigFieldType type;
+  uint8_t         offset, size;   // Within DeviceConfig
+  int32_t         min, max;       // min < 0 = signed
+};
+
+extern const ConfigField CONFIG_FIELDS[];
+extern const uint8_t CONFIG_FIELD_COUNT;
+
+const ConfigField* configField(const char* name, size_t length);
+int32_t configFieldGet(const DeviceConfig& config, const ConfigField& field);            // Numbers and the DMX protocol
+const uint8_t* configFieldIp(const DeviceConfig& config, const ConfigField& field);
+bool configFieldSet(DeviceConfig& config, const ConfigField& field, int32_t value);      // False if out of range
+bool configFieldSetText(DeviceConfig& config, const ConfigField& field, const char* text, size_t length); // Address, protocol name or number
+
+#ifdef ARDUINO
+enum ConfigSource : uint8_t { CONFIG_FROM_BLOB, CONFIG_FROM_KEYS, CONFIG_FROM_DEFAULTS };
+
+// One blob read at boot, over the defaults `config` holds. Without a valid
+// blob, settings saved by firmware before the record existed are read from
+// their old keys once, stored as a blob, and the old keys removed.
+ConfigSource configLoad(DeviceConfig& config);
+bool configSave(DeviceConfig& config);            // One blob write, none if nothing changed
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+#include "dmx.h"
+#include <string.h>
+
+#define ARTNET_OP_DMX   0x5000
+#define ARTNET_OP_SYNC  0x5200
+#define ARTNET_HEADER   18        // Up to and including the length field
+
+#define E131_VECTOR_ROOT_DATA       0x00000004
+#define E131_VECTOR_ROOT_EXTENDED   0x00000008
+#define E131_VECTOR_FRAMING_DATA    0x00000002
+#define E131_VECTOR_EXTENDED_SYNC   0x00000001
+#define E131_OPTION_PREVIEW         0x80
+#define E131_DATA_OFFSET            126   // First slot after the start code
+#define E131_SYNC_SIZE              49
+
+static const uint8_t ARTNET_ID[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+static const uint8_t E131_ID[12]  = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+static inline uint16_t be16(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+static inline uint32_t be32(const uint8_t* p) { return ((uint32_t)be16(p) << 16) | be16(p + 2); }
+
+DmxKind artnetDecode(const uint8_t* p, int size, DmxPacket& out) {
+  if (size < 12 || memcmp(p, ARTNET_ID, sizeof(ARTNET_ID)) != 0) { return DMX_NONE; }
+  uint16_t opcode = p[8] | (p[9] << 8);   // Art-Net opcodes are little endian
+  if (opcode == ARTNET_OP_SYNC) { return DMX_SYNC; }
+  if (opcode != ARTNET_OP_DMX || size < ARTNET_HEADER) { return DMX_NONE; }
+  uint16_t length = be16(p + 16);
+  if (length > DMX_SLOTS || ARTNET_HEADER + length > size) { return DMX_NONE; }
+  out.universe = ((p[15] & 0x7F) << 8) | p[14]; // Net, then Sub-Net and Universe
+  out.count = length;
+  out.slots = p + ARTNET_HEADER;
+  out.sequence = p[12];
+  out.waitForSync = false;                // Art-Net sync mode is inferred from ArtSync traffic
+  return DMX_DATA;
+}
+
+DmxKind e131Decode(const uint8_t* p, int size, DmxPacket& out) {
+  if (size < E131_SYNC_SIZE || be16(p) != 0x0010 || memcmp(p + 4, E131_ID, sizeof(E131_ID)) != 0) { return DMX_NONE; }
+  uint32_t rootVector = be32(p + 18);
+  if (rootVector == E131_VECTOR_ROOT_EXTENDED) {
+    return be32(p + 40) == E131_VECTOR_EXTENDED_SYNC ? DMX_SYNC : DMX_NONE; // Discovery is ignored
+  }
+  if (rootVector != E131_VECTOR_ROOT_DATA || size <= E131_DATA_OFFSET) { return DMX_NONE; }
+  if (be32(p + 40) != E131_VECTOR_FRAMING_DATA || (p[112] & E131_OPTION_PREVIEW)) { return DMX_NONE; }
+  if (p[125] != 0) { return DMX_NONE; }   // Only the null start code carries levels
+  uint16_t count = be16(p + 123) - 1;     // Property count includes the start code
+  if (count > DMX_SLOTS || E131_DATA_OFFSET + count > size) { return DMX_NONE; }
+  out.universe = be16(p + 113);
+  out.count = count;
+  out.slots = p + E131_DATA_OFFSET;
+  out.sequence = p[111];
+  out.waitForSync = be16(p + 109) != 0;   // Non-zero synchronization address
+  return DMX_DATA;
+}
+
+bool dmxMapUniverse(uint16_t firstUniverse, uint16_t start, uint16_t universe,
+                    uint16_t& firstPixel, uint16_t& firstSlot) {
+  if (universe < firstUniverse || start < 1 || start > DMX_SLOTS) { return false; }
+  uint16_t k = universe - firstUniverse;
+  if (k == 0) {
+    firstPixel = 0;
+    firstSlot = start - 1;
+  } else {
+    uint32_t pixel = (DMX_SLOTS - (start - 1)) / 3 + (uint32_t)(k - 1) * DMX_PIXELS_PER_UNIVERSE;
+    if (pixel > 0xFFFF) { return false; }
+    firstPixel = pixel;
+    firstSlot = 0;
+  }
+  return true;
+}
+
+const char* dmxProtocolName(uint8_t protocol) {
+  switch (protocol) {
+    case DMX_ARTNET: return "artnet";
+    case DMX_SACN:   return "sacn";
+    default:         return "off";
+  }
+}
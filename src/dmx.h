@@ -0,0 +1,41 @@
+#ifndef DMX_H
+#define DMX_H
+
+#include <stdint.h>
+
+#define ARTNET_PORT       6454
+#define E131_PORT         5568
+#define DMX_SLOTS         512
+#define DMX_PACKET_SIZE   640     // Largest E1.31 data packet (638 bytes), rounded up
+#define DMX_PIXELS_PER_UNIVERSE 170   // 510 slots of RGB, the usual console patch
+#define DMX_SYNC_TIMEOUT_MS     4000  // Fall back to immediate output when syncs stop
+
+enum DmxProtocol : uint8_t { DMX_OFF = 0, DMX_ARTNET, DMX_SACN };
+
+enum DmxKind : uint8_t {
+  DMX_NONE = 0,   // Not a packet we handle
+  DMX_DATA,       // Slot data for one universe
+  DMX_SYNC        // Universe sync, output everything received so far
+};
+
+// One decoded packet. `slots` points into the received packet, nothing is copied.
+struct DmxPacket {
+  uint16_t universe;
+  uint16_t count;         // Number of slots, without the start code
+  const uint8_t* slots;   // Slot 1 of the universe
+  uint8_t sequence;
+  bool waitForSync;       // Sender will follow up with a sync packet (sACN only)
+};
+
+DmxKind artnetDecode(const uint8_t* packet, int size, DmxPacket& out);
+DmxKind e131Decode(const uint8_t* packet, int size, DmxPacket& out);
+
+// Where a universe lands on the canvas. The first universe starts at `start`
+// (DMX address 1-512); following universes continue with DMX_PIXELS_PER_UNIVERSE
+// pixels each from slot 1. Returns false if the universe is not ours.
+bool dmxMapUniverse(uint16_t firstUniverse, uint16_t start, uint16_t universe,
+                    uint16_t& firstPixel, uint16_t& firstSlot);
+
+const char* dmxProtocolName(uint8_t protocol);
+
+#endif
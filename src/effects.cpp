@@ -0,0 +1,393 @@
+#include "effects.h"
+#include <string.h>
+
+#define PULSE_DEFAULT_MS      500   // Length of a pulse if none is given
+#define COUNTDOWN_DEFAULT_MS  10000 // Length of a countdown if none is given
+#define CHASE_STEP_MS         30    // Time per pixel the chase head moves
+#define CHASE_LENGTH          6     // Lit pixels in the chase tail
+#define FLASH_HALF_PERIOD_MS  100   // On/off time of the flash
+#define LATCH_LEAD_US         3000  // Task wakes this long before a latch to render, then spins
+
+static const char* const EFFECT_NAMES[EFFECT_COUNT] = { "solid", "pulse", "chase", "countdown", "flash" };
+
+// Levels are 16-bit (0-65535) so slow fades keep their resolution until the
+// output stage decides how to reduce them to 8 bits.
+static inline uint16_t scale16(uint16_t v, uint16_t level) { return ((uint32_t)v * (level + 1u)) >> 16; }
+
+static void fillScaled(uint16_t* rgb, uint16_t first, uint16_t count, uint32_t color, uint16_t level) {
+  uint16_t r = scale16(((color >> 16) & 0xFF) * 257, level);
+  uint16_t g = scale16(((color >> 8) & 0xFF) * 257, level);
+  uint16_t b = scale16((color & 0xFF) * 257, level);
+  uint16_t* p = rgb + first * 3;
+  for (uint16_t i = 0; i < count; i++) { *p++ = r; *p++ = g; *p++ = b; }
+}
+
+bool effectRender(const EffectState& state, uint32_t nowMs, uint16_t* rgb, uint16_t numPixels) {
+  uint32_t elapsed = nowMs - state.startMs;
+  uint32_t duration = state.durationMs;
+  uint16_t bright = state.brightness * 257;
+
+  switch (state.type) {
+    case EFFECT_PULSE: {
+      if (duration == 0) { duration = PULSE_DEFAULT_MS; }
+      if (elapsed >= duration) { return false; }
+      uint32_t phase = (uint64_t)elapsed * 131070 / duration;     // Up then down
+      uint32_t tri = phase < 65535 ? phase : 131070 - phase;
+      uint32_t eased = (uint64_t)tri * tri / 65535;               // Quadratic ease
+      uint16_t level = 16448 + eased * 49087 / 65535;             // Never below a quarter
+      fillScaled(rgb, 0, numPixels, state.color, scale16(level, bright));
+      return true;
+    }
+    case EFFECT_CHASE: {
+      if (duration && elapsed >= duration) { return false; }
+      fillScaled(rgb, 0, numPixels, state.color, bright >> 3);    // Dim background
+      if (numPixels == 0) { return true; }
+      uint16_t head = (elapsed / CHASE_STEP_MS) % numPixels;
+      for (uint8_t i = 0; i < CHASE_LENGTH && i < numPixels; i++) {
+        uint16_t pos = (head + numPixels - i) % numPixels;
+        fillScaled(rgb, pos, 1, state.color, bright - ((uint32_t)bright * i) / CHASE_LENGTH);
+      }
+      return true;
+    }
+    case EFFECT_COUNTDOWN: {
+      if (duration == 0) { duration = COUNTDOWN_DEFAULT_MS; }
+      if (elapsed >= duration) { return false; }
+      uint16_t lit = ((uint64_t)numPixels * (duration - elapsed) + duration - 1) / duration;
+      fillScaled(rgb, 0, lit, state.color, bright);
+      memset(rgb + lit * 3, 0, (numPixels - lit) * 3 * sizeof(uint16_t));
+      return true;
+    }
+    case EFFECT_FLASH: {
+      if (duration && elapsed >= duration) { return false; }
+      bool on = ((elapsed / FLASH_HALF_PERIOD_MS) & 1) == 0;
+      fillScaled(rgb, 0, numPixels, on ? state.color : 0, bright);
+      return true;
+    }
+    case EFFECT_SOLID:
+    default:
+      if (duration && elapsed >= duration) { return false; }
+      fillScaled(rgb, 0, numPixels, state.color, bright);
+      return true;
+  }
+}
+
+EffectType effectFromName(const char* name) {
+  for (uint8_t i = 0; i < EFFECT_COUNT; i++) {
+    if (strcmp(name, EFFECT_NAMES[i]) == 0) { return static_cast<EffectType>(i); }
+  }
+  return EFFECT_COUNT;
+}
+
+const char* effectName(uint8_t type) {
+  return type < EFFECT_COUNT ? EFFECT_NAMES[type] : "none";
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "latch.h"
+
+static Canvas* canvas = nullptr;
+static TaskHandle_t effectsTaskHandle = NULL;
+static FrameLibrary frameLibs[CANVAS_MAX_SEGMENTS];
+static uint8_t segmentCount = 0;
+static uint16_t maxPixels = 0;
+
+static portMUX_TYPE stateMux = portMUX_INITIALIZER_UNLOCKED;
+// The canvas and the stored frames belong to whoever holds this: the task
+// while it renders and shows a frame, other writers while they draw. A
+// frame is never shown half-written, and the copies run with interrupts on.
+static SemaphoreHandle_t canvasLock = NULL;
+static EffectState baseState = { EFFECT_SOLID, 0, FRAME_OFF, 0, 0, 0 };
+static EffectState activeState;
+static bool effectActive = false;
+static uint32_t frameGeneration = 0;   // Bumped whenever a stored frame is rebuilt
+static EffectStats stats = { 0, 0, UINT32_MAX, 0, 0, 0, 0, 0, 0 };
+
+static volatile bool ditherWanted = false;     // Applied by the task, which owns the canvas buffers
+
+static volatile bool holding = false;  // Output stopped, the canvas and effect state are being staged
+static volatile bool latchPending = false;
+static volatile uint32_t latchAtUs = 0;
+static uint32_t holdStartMs = 0;
+static uint32_t latchMs = 0;           // millis() at the latch, the time the latched frame is rendered for
+static bool latchSpin = false;         // Next show() waits for latchAtUs
+
+static uint16_t* frame = nullptr;      // Sized to the canvas in effectsBegin()
+static uint16_t* lastFrame = nullptr;
+static bool frameShown = false;        // lastFrame holds what is on the strips
+static bool frameExact = true;         // lastFrame needs no dithering to be shown
+
+static AnimClip nextClip;              // Set by effectsPlayClip(), points into flash
+static bool clipRestart = false;
+static AnimClip clip;                  // Copy the task plays from
+static int32_t clipShown = -1;         // Frame of it on the canvas, -1 = none
+static uint8_t shownFrameId = FRAME_NONE;
+static uint32_t shownGeneration = 0;
+
+// Everything is rendered before the spin, so show() starts as close to the
+// latch time as the clock allows, whatever the frame took to build.
+static void present() {
+  if (latchSpin) {
+    while ((int32_t)(latchAtUs - micros()) > 0) { }
+    uint32_t late = micros() - latchAtUs;
+    portENTER_CRITICAL(&stateMux);
+    if (late > stats.latchLateUs) { stats.latchLateUs = late; }
+    portEXIT_CRITICAL(&stateMux);
+    latchSpin = false;
+  }
+  canvas->show();
+}
+
+// Held until the latch: waits for it, and for a lost latch gives up after
+// LATCH_HOLD_TIMEOUT_MS. Returns false while still holding. Effects started
+// during the hold are moved to the latch time, so they run in step on every
+// slave.
+static bool releaseHold() {
+  if (!latchPending) {
+    uint32_t held = millis() - holdStartMs;
+    if (held < LATCH_HOLD_TIMEOUT_MS) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LATCH_HOLD_TIMEOUT_MS - held) + 1);
+      return false;
+    }
+    portENTER_CRITICAL(&stateMux);
+    stats.holdTimeouts++;
+    portEXIT_CRITICAL(&stateMux);
+    holding = false;
+    return true;
+  }
+  int32_t wait = (int32_t)(latchAtUs - micros()) - LATCH_LEAD_US;
+  if (wait > 0) { vTaskDelay(pdMS_TO_TICKS(wait / 1000)); }
+  int32_t ahead = (int32_t)(latchAtUs - micros());
+  latchMs = millis() + (ahead > 0 ? ahead / 1000 : 0);
+  portENTER_CRITICAL(&stateMux);
+  if ((int32_t)(activeState.startMs - holdStartMs) >= 0) { activeState.startMs = latchMs; }
+  if ((int32_t)(baseState.startMs - holdStartMs) >= 0) { baseState.startMs = latchMs; }
+  stats.latches++;
+  portEXIT_CRITICAL(&stateMux);
+  latchSpin = true;
+  latchPending = false;
+  holding = false;
+  return true;
+}
+
+static void outputFrame(uint16_t numPixels) {
+  size_t bytes = numPixels * 3 * sizeof(uint16_t);
+  if (frameShown && frameExact && memcmp(frame, lastFrame, bytes) == 0) { return; } // Nothing changed
+  frameExact = canvas->write16(0, frame, numPixels); // In-between levels keep dithering every frame
+  present();
+  memcpy(lastFrame, frame, bytes);
+  frameShown = true;
+  shownFrameId = FRAME_NONE;
+}
+
+static void outputStoredFrame(uint8_t id) {
+  portENTER_CRITICAL(&stateMux);
+  uint32_t generation = frameGeneration;
+  portEXIT_CRITICAL(&stateMux);
+  if (id == shownFrameId && shownGeneration == generation) { return; }
+  for (uint8_t s = 0; s < segmentCount; s++) { frameLibs[s].apply(static_cast<FrameId>(id)); } // Under canvasLock
+  shownGeneration = generation;
+  present();
+  shownFrameId = id;
+  frameShown = false;
+}
+
+// Advances the clip to the frame due at `nowMs`. Returns false once a clip
+// that does not loop (durationMs set) has played its last frame.
+static bool clipRender(const EffectState& state, uint32_t nowMs) {
+  uint32_t index = (uint64_t)(nowMs - state.startMs) * clip.header->fps / 1000;
+  uint16_t frames = clip.header->frameCount;
+  if (index >= frames) {
+    if (state.durationMs) { return false; }
+    index %= frames;
+  }
+  if (!animApply(*canvas, clip, clipShown, index)) { return false; }
+  clipShown = index;
+  return true;
+}
+
+static void updateStats(uint32_t us, uint32_t periodUs) {
+  stats.frames++;
+  stats.lastUs = us;
+  if (us < stats.minUs) { stats.minUs = us; }
+  if (us > stats.maxUs) { stats.maxUs = us; }
+  stats.avgUs = stats.avgUs ? stats.avgUs - (stats.avgUs >> 4) + (us >> 4) : us;
+  if (us > periodUs) { stats.overruns++; }
+}
+
+static void effectsTask(void*) {
+  TickType_t period = pdMS_TO_TICKS(1000 / EFFECTS_FPS);
+  TickType_t nextWake = xTaskGetTickCount() + period;
+  for (;;) {
+    // Fixed rate, independent of render time. effectsKick() wakes the task
+    // early so streamed pixels go out without waiting for the next frame.
+    // Dithering only works if the frames alternate faster than the eye, so
+    // the rate goes up to DITHER_FPS while it is on.
+    if (ditherWanted != canvas->dithering()) {
+      if (!canvas->setDither(ditherWanted)) { ditherWanted = false; }
+      period = pdMS_TO_TICKS(1000 / (canvas->dithering() ? DITHER_FPS : EFFECTS_FPS));
+      frameShown = false;
+    }
+    bool kicked;
+    if (holding) {
+      if (!releaseHold()) { continue; }
+      kicked = true;
+      nextWake = xTaskGetTickCount() + period;     // Later frames keep the latch's phase
+    } else {
+      TickType_t ticks = xTaskGetTickCount();
+      kicked = ulTaskNotifyTake(pdTRUE, (int32_t)(nextWake - ticks) > 0 ? nextWake - ticks : 0) > 0;
+      while ((int32_t)(xTaskGetTickCount() - nextWake) >= 0) { nextWake += period; } // Skip missed frames
+    }
+    uint32_t start = micros();
+    uint32_t now = latchSpin ? latchMs : millis();
+
+    EffectState state;
+    bool active;
+    portENTER_CRITICAL(&stateMux);
+    active = effectActive;
+    state = active ? activeState : baseState;
+    if (clipRestart) {
+      clip = nextClip;
+      clipShown = -1;
+      clipRestart = false;
+    }
+    portEXIT_CRITICAL(&stateMux);
+
+    xSemaphoreTake(canvasLock, portMAX_DELAY);    // Until the frame is out
+    if (active) {
+      bool done = (state.frame != FRAME_NONE) ? (state.durationMs && now - state.startMs >= state.durationMs)
+                : (state.type == EFFECT_CLIP)   ? !clipRender(state, now)
+                : !effectRender(state, now, frame, maxPixels);
+      if (done) {
+        portENTER_CRITICAL(&stateMux);
+        if (effectActive && activeState.startMs == state.startMs) { effectActive = false; } // Not replaced meanwhile
+        state = baseState;
+        portEXIT_CRITICAL(&stateMux);
+      }
+    }
+    if (state.type == EFFECT_DIRECT || state.type == EFFECT_CLIP) {
+      if (kicked || state.type == EFFECT_CLIP) { present(); } // Direct writers decide when a frame is complete
+      shownFrameId = FRAME_NONE;
+      frameShown = false;
+    }
+    else if (state.frame != FRAME_NONE) { outputStoredFrame(state.frame); }
+    else { outputFrame(maxPixels); }
+    if (state.type != EFFECT_CLIP) { clipShown = -1; } // Canvas gets overwritten, a clip starts over
+    latchSpin = false;                             // Frame was unchanged, nothing to line up
+    xSemaphoreGive(canvasLock);
+
+    uint32_t us = micros() - start;
+    portENTER_CRITICAL(&stateMux);
+    updateStats(us, period * portTICK_PERIOD_MS * 1000);
+    portEXIT_CRITICAL(&stateMux);
+  }
+}
+
+void effectsBegin(Canvas& c) {
+  canvas = &c;
+  segmentCount = c.segmentCount();
+  for (uint8_t s = 0; s < segmentCount; s++) { frameLibs[s].begin(&c.segment(s), c.segmentType(s)); }
+  maxPixels = min<uint16_t>(c.numPixels(), EFFECTS_MAX_PIXELS);
+  frame = (uint16_t*)calloc(maxPixels * 3 + 1, sizeof(uint16_t));
+  lastFrame = (uint16_t*)calloc(maxPixels * 3 + 1, sizeof(uint16_t));
+  if (!frame || !lastFrame) { maxPixels = 0; } // Stored frames still work, rendered effects are skipped
+  canvasLock = xSemaphoreCreateMutex();          // Priority inheritance: a writer holding it finishes first
+  xTaskCreatePinnedToCore(effectsTask, "effects", 4096, NULL, EFFECTS_TASK_PRIO, &effectsTaskHandle, EFFECTS_TASK_CORE);
+}
+
+void effectsDefineFrame(FrameId id, uint32_t color, uint8_t brightness) {
+  effectsLockCanvas();                           // Not while the task copies a frame out
+  bool rebuilt = false;
+  for (uint8_t s = 0; s < segmentCount; s++) { rebuilt |= frameLibs[s].define(id, color, brightness); }
+  portENTER_CRITICAL(&stateMux);
+  if (rebuilt) { frameGeneration++; }
+  portEXIT_CRITICAL(&stateMux);
+  effectsUnlockCanvas();
+}
+
+void effectsSetBase(FrameId id) {
+  portENTER_CRITICAL(&stateMux);
+  baseState = { EFFECT_SOLID, 0, id, frameLibs[0].color(id), millis(), 0 };
+  portEXIT_CRITICAL(&stateMux);
+}
+
+void effectsShowFrame(FrameId id, uint32_t durationMs) {
+  portENTER_CRITICAL(&stateMux);
+  activeState = { EFFECT_SOLID, 0, id, frameLibs[0].color(id), millis(), durationMs };
+  effectActive = true;
+  portEXIT_CRITICAL(&stateMux);
+}
+
+void effectsPlay(EffectType type, uint32_t color, uint8_t brightness, uint32_t durationMs) {
+  portENTER_CRITICAL(&stateMux);
+  if (color == 0) { color = baseState.color; } // Effects default to the current base colour
+  activeState = { type, brightness, FRAME_NONE, color, millis(), durationMs };
+  effectActive = true;
+  portEXIT_CRITICAL(&stateMux);
+}
+
+void effectsPlayClip(const AnimClip& c, bool loop) {
+  if (!c.header->frameCount) { return; }
+  uint32_t length = (uint32_t)c.header->frameCount * 1000 / c.header->fps;
+  portENTER_CRITICAL(&stateMux);
+  nextClip = c;
+  clipRestart = true;
+  activeState = { EFFECT_CLIP, 0, FRAME_NONE, 0, millis(), loop ? 0 : max<uint32_t>(length, 1) };
+  effectActive = true;
+  portEXIT_CRITICAL(&stateMux);
+}
+
+void effectsStop() {
+  portENTER_CRITICAL(&stateMux);
+  effectActive = false;
+  portEXIT_CRITICAL(&stateMux);
+}
+
+void effectsDirect() {
+  portENTER_CRITICAL(&stateMux);
+  effectActive = false;
+  baseState = { EFFECT_DIRECT, 0, FRAME_NONE, baseState.color, millis(), 0 };
+  portEXIT_CRITICAL(&stateMux);
+}
+
+void effectsLockCanvas() {
+  if (canvasLock) { xSemaphoreTake(canvasLock, portMAX_DELAY); }
+}
+
+void effectsUnlockCanvas() {
+  if (canvasLock) { xSemaphoreGive(canvasLock); }
+}
+
+void effectsSetDither(bool on) {
+  ditherWanted = on;
+  effectsKick();
+}
+
+bool effectsDithering() {
+  return canvas && canvas->dithering();
+}
+
+void effectsKick() {
+  if (effectsTaskHandle) { xTaskNotifyGive(effectsTaskHandle); }
+}
+
+void effectsHold() {
+  if (holding) { return; }
+  holdStartMs = millis();
+  holding = true;
+}
+
+void effectsLatch(uint32_t atUs) {
+  effectsHold();                                   // A latch without staged writes still shows in step
+  latchAtUs = atUs;
+  latchPending = true;
+  effectsKick();
+}
+
+EffectStats effectsGetStats() {
+  portENTER_CRITICAL(&stateMux);
+  EffectStats copy = stats;
+  portEXIT_CRITICAL(&stateMux);
+  return copy;
+}
+#endif
@@ -0,0 +1,77 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <stdint.h>
+
+#define EFFECTS_FPS         50    // Fixed frame rate of the effect task
+#define DITHER_FPS          250   // Output rate while the 16-bit canvas is dithered
+#define EFFECTS_MAX_PIXELS  1024  // Largest canvas the engine renders for
+#define EFFECTS_TASK_CORE   1     // Same core as loop(), network stays on core 0
+#define EFFECTS_TASK_PRIO   2     // Just above loop() so frames stay on time
+
+enum EffectType : uint8_t {
+  EFFECT_SOLID = 0,   // Plain colour, optionally for a limited time
+  EFFECT_PULSE,       // Single swell and fade, used on button press
+  EFFECT_CHASE,       // Running segment, used while "armed"
+  EFFECT_COUNTDOWN,   // Bar shrinking from full to empty over the duration
+  EFFECT_FLASH,       // Strobe, used for the winner
+  EFFECT_COUNT,
+  EFFECT_DIRECT = 0x80, // Nothing rendered, pixels are written to the canvas directly
+  EFFECT_CLIP          // Frames of a flash animation, see anim.h
+};
+
+struct EffectState {
+  uint8_t  type;        // EffectType
+  uint8_t  brightness;  // 0-255, applied while rendering
+  uint8_t  frame;       // FrameId of a precomputed solid frame, 0xFF when rendered
+  uint32_t color;       // Packed 0x00RRGGBB
+  uint32_t startMs;     // millis() when the effect was started
+  uint32_t durationMs;  // 0 = run until replaced
+};
+
+struct EffectStats {
+  uint32_t frames;      // Frames rendered since boot
+  uint32_t lastUs;      // Render + output time of the last frame
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t avgUs;       // Running average over the last ~16 frames
+  uint32_t overruns;    // Frames that took longer than the frame period
+  uint32_t latches;     // Held frames shown by effectsLatch()
+  uint32_t latchLateUs; // Latest show() start after a latch time
+  uint32_t holdTimeouts; // Held frames shown without a latch
+};
+
+// Renders one frame of `state` at time `nowMs` into `rgb` (3 x 16-bit values
+// per pixel, R,G,B order). Returns false once a timed effect has finished.
+// Pure function without Arduino dependencies so it can be built and
+// benchmarked on a host.
+bool effectRender(const EffectState& state, uint32_t nowMs, uint16_t* rgb, uint16_t numPixels);
+
+// Maps an effect name ("pulse", "chase", ...) to its type, EFFECT_COUNT if unknown.
+EffectType effectFromName(const char* name);
+const char* effectName(uint8_t type);
+
+#ifdef ARDUINO
+#include "frames.h"
+#include "canvas.h"
+#include "anim.h"
+
+void effectsBegin(Canvas& canvas);
+void effectsDefineFrame(FrameId id, uint32_t color, uint8_t brightness); // Rebuilds the frame only if it changed
+void effectsSetBase(FrameId id);                          // Shown whenever no effect is running
+void effectsShowFrame(FrameId id, uint32_t durationMs);   // Frame on top of the base, 0 = until replaced
+void effectsPlay(EffectType type, uint32_t color, uint8_t brightness, uint32_t durationMs);
+void effectsPlayClip(const AnimClip& clip, bool loop);    // Flash animation, once or until replaced
+void effectsStop();                                       // Back to the base colour
+void effectsDirect();                                     // Stop rendering, canvas is written by the caller
+void effectsKick();                                       // Push direct canvas writes now
+void effectsLockCanvas();                                 // Held around every canvas write from outside the task
+void effectsUnlockCanvas();
+void effectsHold();                                       // Show nothing new until effectsLatch(), see latch.h
+void effectsLatch(uint32_t atUs);                         // Show what was held when micros() reaches atUs
+void effectsSetDither(bool on);                           // 16-bit output dithered at DITHER_FPS
+bool effectsDithering();
+EffectStats effectsGetStats();
+#endif
+
+#endif
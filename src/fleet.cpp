@@ -0,0 +1,51 @@
+#include "fleet.h"
+#include <stdio.h>
+#include <string.h>
+
+void fleetMacText(const uint8_t mac[6], char text[FLEET_MAC_TEXT]) {
+  snprintf(text, FLEET_MAC_TEXT, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') { return c - '0'; }
+  if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+  if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+  return -1;
+}
+
+bool fleetParseMac(const char* text, uint8_t mac[6]) {
+  for (uint8_t i = 0; i < 6; i++, text += 3) {
+    int high = hexDigit(text[0]), low = high < 0 ? -1 : hexDigit(text[1]);
+    if (low < 0) { return false; }
+    char end = text[2];
+    if (i < 5 ? (end != ':' && end != '-') : end != '\0') { return false; }
+    mac[i] = high * 16 + low;
+  }
+  return true;
+}
+
+bool fleetForMe(const OSCView& view, const uint8_t mac[6]) {
+  const char* text;
+  uint8_t target[6];
+  return oscViewString(view, 0, text) && fleetParseMac(text, target) && memcmp(target, mac, 6) == 0;
+}
+
+const char* fleetApplyFields(const OSCView& view, uint8_t first, DeviceConfig& next) {
+  static char problem[48];
+  uint8_t args = strlen(view.types);
+  if (args <= first || (args - first) % 2) { return "expected name, value pairs"; }
+  for (uint8_t i = first; i < args; i += 2) {
+    const char* name;
+    const ConfigField* field;
+    if (!oscViewString(view, i, name) || !(field = configField(name, strlen(name)))) { return "unknown field"; }
+    int32_t number;
+    const char* text;
+    bool ok = oscViewInt(view, i + 1, number) ? configFieldSet(next, *field, number)
+            : oscViewString(view, i + 1, text) && configFieldSetText(next, *field, text, strlen(text));
+    if (!ok) {
+      snprintf(problem, sizeof(problem), "invalid %s", field->name);
+      return problem;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,32 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+#include "config.h"
+#include "osc_view.h"
+
+// Discovery and provisioning of a whole fleet over broadcast, so podiums no
+// longer have to be paired over Bluetooth one by one:
+//   /discover                        every slave answers
+//   /discover/reply <mac> <id> <ip> <version> <uptime_ms>
+//   /provision <mac> <name> <value>... only the slave with that MAC applies
+//   /provision/ack <mac> <ok> <message>
+// A setup tool sends one bundle with a /provision per MAC; each slave finds
+// its own. Replies are broadcast to the sender's port, because a slave that
+// still has the factory address may not be on the tool's subnet. Fields are
+// the /config/set names of config.h. tools/provision.cpp is the tool and
+// tools/fleetsim.cpp a simulated fleet to try it against.
+#define FLEET_MAC_TEXT 18       // "AA:BB:CC:DD:EE:FF" and the terminator
+
+void fleetMacText(const uint8_t mac[6], char text[FLEET_MAC_TEXT]);
+bool fleetParseMac(const char* text, uint8_t mac[6]);  // Either case, ':' or '-'
+
+// True if the /provision message is addressed to `mac`.
+bool fleetForMe(const OSCView& view, const uint8_t mac[6]);
+
+// Applies the name/value pairs from argument `first` on to `next`. Values
+// are ints or strings (see configFieldSetText). Returns what was wrong, or
+// null; `next` is then partly changed and should be dropped.
+const char* fleetApplyFields(const OSCView& view, uint8_t first, DeviceConfig& next);
+
+#endif
@@ -0,0 +1,47 @@
+#include "frames.h"
+#include "canvas.h"
+
+bool FrameLibrary::begin(Adafruit_NeoPixel* s, neoPixelType t) {
+  strip = s;
+  type = t;
+  uint8_t bpp = (((t >> 6) & 3) == ((t >> 4) & 3)) ? 3 : 4; // W offset equals R offset on RGB strips
+  frameBytes = strip->numPixels() * bpp;
+  free(buffer);
+  buffer = canvasAlloc((size_t)FRAME_COUNT * frameBytes); // Large strips keep their frames in PSRAM
+  return buffer != nullptr;
+}
+
+bool FrameLibrary::define(FrameId id, uint32_t c, uint8_t brightness) {
+  if (id >= FRAME_COUNT) { return false; }
+  if (colors[id] == c && levels[id] == brightness) { return false; } // Already built
+  colors[id] = c;
+  levels[id] = brightness;
+  build(id);
+  return true;
+}
+
+bool FrameLibrary::apply(FrameId id) {
+  if (id >= FRAME_COUNT || !buffer || !strip->getPixels()) { return false; }
+  memcpy(strip->getPixels(), buffer + id * frameBytes, frameBytes);
+  strip->markDirty(sums[id]);               // Known sums, no recount for the power estimate
+  return true;
+}
+
+void FrameLibrary::build(FrameId id) {
+  if (!buffer || frameBytes == 0) { return; }
+  uint8_t wOffset = (type >> 6) & 3, rOffset = (type >> 4) & 3, gOffset = (type >> 2) & 3, bOffset = type & 3;
+  uint8_t bpp = (wOffset == rOffset) ? 3 : 4;
+  uint16_t scale = levels[id] + 1;
+  uint8_t* frame = buffer + id * frameBytes;
+  uint32_t c = colors[id];
+
+  // Build one pixel in wire order, then replicate it by doubling copies
+  if (bpp == 4) { frame[wOffset] = ((uint8_t)(c >> 24) * scale) >> 8; }
+  frame[rOffset] = ((uint8_t)(c >> 16) * scale) >> 8;
+  frame[gOffset] = ((uint8_t)(c >> 8) * scale) >> 8;
+  frame[bOffset] = ((uint8_t)c * scale) >> 8;
+  for (uint32_t filled = bpp; filled < frameBytes; filled *= 2) {
+    memcpy(frame + filled, frame, min<uint32_t>(filled, frameBytes - filled));
+  }
+  for (uint8_t i = 0; i < 4; i++) { sums[id][i] = i < bpp ? (uint32_t)frame[i] * (frameBytes / bpp) : 0; }
+}
@@ -0,0 +1,38 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <Adafruit_NeoPixel.h>
+
+enum FrameId : uint8_t {
+  FRAME_OFF = 0,  // All pixels dark
+  FRAME_BOOT,     // White at boot
+  FRAME_IDLE,     // Blue or magenta, depending on device_id
+  FRAME_HIT,      // Red after /device/ matched this podium
+  FRAME_COUNT,
+  FRAME_NONE = 0xFF
+};
+
+// Named solid frames for one strip, kept in wire order (colour order and
+// brightness already applied) so switching state is a single memcpy into the
+// strip buffer. A frame is only rebuilt when its colour or brightness
+// changes; the colour order is fixed at begin(), since SET_STRIP restarts.
+class FrameLibrary {
+public:
+  bool begin(Adafruit_NeoPixel* strip, neoPixelType type);
+  bool define(FrameId id, uint32_t color, uint8_t brightness); // True if the frame was rebuilt
+  bool apply(FrameId id);                   // Copies the frame into the strip buffer
+  uint32_t color(FrameId id) const { return id < FRAME_COUNT ? colors[id] : 0; }
+
+private:
+  void build(FrameId id);
+
+  Adafruit_NeoPixel* strip = nullptr;
+  neoPixelType type = NEO_GRB;
+  uint16_t frameBytes = 0;
+  uint8_t* buffer = nullptr;                // FRAME_COUNT frames back to back
+  uint32_t colors[FRAME_COUNT] = {};
+  uint8_t levels[FRAME_COUNT] = {};
+  uint32_t sums[FRAME_COUNT][4] = {};       // Sum of the bytes at each pixel offset, for the strip's power estimate
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "latch.h"
+
+void latchClockSample(LatchClock& clock, uint32_t masterUs, uint32_t localUs) {
+  int32_t offset = (int32_t)(localUs - masterUs);
+  if (clock.windowCount == 0 || offset < clock.windowMin) {
+    clock.windowMin = offset;
+    clock.windowUs = localUs;
+  }
+  if (++clock.windowCount < LATCH_SYNC_WINDOW) { return; }
+  clock.windowCount = 0;
+  if (!clock.valid) {
+    clock.baseOffsetUs = clock.windowMin;
+    clock.baseUs = clock.windowUs;
+  } else if ((int32_t)(clock.windowUs - clock.baseUs) > LATCH_BASELINE_US) {
+    clock.baseOffsetUs = clock.offsetUs;      // Restart from the last estimate, drift is kept meanwhile
+    clock.baseUs = clock.refUs;
+  }
+  int32_t span = (int32_t)(clock.windowUs - clock.baseUs);
+  if (span >= LATCH_MIN_SPAN_US) {
+    int64_t drift = (int64_t)(clock.windowMin - clock.baseOffsetUs) * 1000000000 / span;
+    if (drift >= -LATCH_MAX_DRIFT_PPM * 1000 && drift <= LATCH_MAX_DRIFT_PPM * 1000) { clock.driftPpb = drift; }
+  }
+  if (clock.valid) {
+    // Each window minimum still carries some delay; blending it into the
+    // drift-corrected previous estimate averages that out
+    int32_t predicted = clock.offsetUs + (int32_t)((int64_t)clock.driftPpb * (int32_t)(clock.windowUs - clock.refUs) / 1000000000);
+    clock.offsetUs = predicted + (clock.windowMin - predicted) / LATCH_SMOOTHING;
+  } else {
+    clock.offsetUs = clock.windowMin;
+  }
+  clock.refUs = clock.windowUs;
+  clock.valid = true;
+}
+
+uint32_t latchClockToLocal(const LatchClock& clock, uint32_t masterUs) {
+  uint32_t local = masterUs + clock.offsetUs;
+  int32_t since = (int32_t)(local - clock.refUs);
+  return local + (int32_t)((int64_t)clock.driftPpb * since / 1000000000);
+}
@@ -0,0 +1,44 @@
+#ifndef LATCH_H
+#define LATCH_H
+
+#include <stdint.h>
+
+// Prepare-then-latch for frames shown by several slaves at once. The master
+// sends the frame or colour command as usual, then one broadcast
+//   /latch [master_us]
+// Writes made before it are held back (see effectsHold()) and every slave
+// shows them when the latch arrives, or, with a time, when its own clock
+// reaches that master time. The master clock is learnt from periodic
+//   /time <master_us>
+// broadcasts. A broadcast reaches every slave at nearly the same moment, so
+// the offset to the master is taken from the sample that was handled
+// fastest in each window (least loop delay) and blended into the previous
+// estimate. Drift is measured against the first window, so its error
+// shrinks as the baseline grows. tools/latchsim.cpp measures the skew.
+#define LATCH_SYNC_WINDOW     8        // /time samples per offset estimate
+#define LATCH_SMOOTHING       4        // Each window moves the offset a quarter of the way
+#define LATCH_MAX_DRIFT_PPM   200      // Anything beyond this is a bad estimate
+#define LATCH_MIN_SPAN_US     5000000  // Drift is only estimated over at least 5 s
+#define LATCH_BASELINE_US     600000000 // Baseline restarts after 10 minutes, well inside the micros() wrap
+#define LATCH_MAX_AHEAD_US    1000000  // Latch times further out are shown at once
+#define LATCH_MODE_TIMEOUT_MS 5000     // Writes are held while latches came this recently
+#define LATCH_HOLD_TIMEOUT_MS 200      // A held frame is shown anyway if its latch got lost
+
+struct LatchClock {
+  bool     valid;        // At least one window completed
+  int32_t  offsetUs;     // local - master at refUs
+  uint32_t refUs;        // Local time of the offset estimate
+  int32_t  driftPpb;     // Local clock gain in parts per billion
+  int32_t  baseOffsetUs; // First estimate of the drift baseline
+  uint32_t baseUs;
+  int32_t  windowMin;    // Smallest local - master in the current window
+  uint32_t windowUs;     // Local time of that sample
+  uint8_t  windowCount;
+};
+
+void latchClockSample(LatchClock& clock, uint32_t masterUs, uint32_t localUs);
+
+// Local micros() value for a master time. Only meaningful once valid.
+uint32_t latchClockToLocal(const LatchClock& clock, uint32_t masterUs);
+
+#endif
@@ -0,0 +1,16 @@
+#include "line_reader.h"
+
+const char* lineReaderPut(LineReader& reader, char c) {
+  if (c == '\r') { return nullptr; }
+  if (c == '\n') {
+    bool complete = !reader.overflow;
+    if (!complete) { reader.dropped++; }
+    reader.buffer[reader.length] = '\0';
+    reader.length = 0;
+    reader.overflow = false;
+    return complete ? reader.buffer : nullptr;
+  }
+  if (reader.length >= LINE_READER_SIZE - 1) { reader.overflow = true; }
+  else { reader.buffer[reader.length++] = c; }
+  return nullptr;
+}
@@ -0,0 +1,24 @@
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <stdint.h>
+
+// Assembles text commands from a byte stream without waiting for them. The
+// caller hands over whatever has arrived, byte by byte, and gets a line back
+// once its '\n' is in; a line cut across several reads simply completes on a
+// later pass. '\r' is dropped, so CRLF terminals work too. A line longer than
+// the buffer is discarded whole rather than run as a truncated command.
+#define LINE_READER_SIZE 128     // Longest line kept, terminator included
+
+struct LineReader {
+  char     buffer[LINE_READER_SIZE];
+  uint16_t length;
+  bool     overflow;             // Current line no longer fits, skipped up to its '\n'
+  uint32_t dropped;              // Lines discarded for length
+};
+
+// Adds one byte. Returns the completed line, NUL-terminated and without its
+// terminator, or nullptr. The line stays valid until the next call.
+const char* lineReaderPut(LineReader& reader, char c);
+
+#endif
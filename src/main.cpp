@@ -1,11 +1,13 @@
 #define DEBUG     1
 
 #define DEVICE_NAME "BCG_SLAVE_"
+#define FIRMWARE_VERSION "1.1.0" // Reported to /discover
 
-#define NUM_PIXELS  30    // Number of NeoPixels in the strip1
-#define LED_PIN1    13    // GPIO pin for NeoPixel strip1
-#define LED_PIN2    14    // GPIO pin for second NeoPixel strip2
-#define LED_PIN3    33    // GPIO pin for third NeoPixel strip3
+#define NUM_PIXELS  30    // Default number of NeoPixels in each strip
+#define LED_PIN1    13    // Default GPIO pin for NeoPixel strip1
+#define LED_PIN2    14    // Default GPIO pin for second NeoPixel strip2
+#define LED_PIN3    33    // Default GPIO pin for third NeoPixel strip3
+#define MAX_STRIPS  4     // Strip slots that can be set with SET_STRIP
 #define SWITCH_PIN  32    // GPIO pin for the switch input
 
 #define RED   255, 0,   0  // Red color value for NeoPixel
@@ -15,100 +17,357 @@
 #define MAGENTA 255, 0, 255 // Magenta color value for NeoPixel
 
 #define DEBOUNCE_DELAY 500 // Debounce delay for switch input in milliseconds
+#define OSC_PACKET_SIZE 1472 // Largest UDP payload that fits one Ethernet frame
+#define KEYFRAME_RETRY_MS 100 // Minimum gap between keyframe requests
+#define OSC_REPLY_SIZE 1400  // /command/reply text, fits HELP and one Ethernet frame
+#define RESTART_DELAY_MS 100 // Lets a reply go out before a restart
+#define RESTART_SAVE_TRIES 3 // Failed settings writes before a restart goes ahead without them
+#define CONFIG_QUIET_MS 2000 // Changed settings are written once none came for this long
+#define DHCP_TIMEOUT_MS 3000 // No DHCP answer this long after link-up: static fallback
+#define BT_WINDOW_S 0        // Default seconds Bluetooth stays on after boot, 0 = always
 
 #include <Arduino.h>
 #include "eth_properties.h"
+#include "effects.h"
+#include "canvas.h"
+#include "osc_view.h"
+#include "dmx.h"
+#include "pixel_delta.h"
+#include "anim.h"
+#include "latch.h"
+#include "config.h"
+#include "line_reader.h"
+#include "command.h"
+#include "fleet.h"
 #include <Adafruit_NeoPixel.h>
 #include <OSCMessage.h>
 #include <ETH.h>
 #include <WiFiUdp.h>
 #include <BluetoothSerial.h>
-#include <Preferences.h>
+#include <esp_bt.h>
+#include <lwip/sockets.h>
+#include <lwip/dhcp.h>
+#include <lwip/tcpip.h>
+#include <tcpip_adapter.h>
 
 BluetoothSerial SerialBT; // Bluetooth Serial
-Adafruit_NeoPixel strip1(NUM_PIXELS, LED_PIN1, NEO_GRB + NEO_KHZ800); // NeoPixel strip1 on GPIO 13
-Adafruit_NeoPixel strip2(NUM_PIXELS, LED_PIN2, NEO_GRB + NEO_KHZ800); // NeoPixel strip2 on GPIO 14
-Adafruit_NeoPixel strip3(NUM_PIXELS, LED_PIN3, NEO_GRB + NEO_KHZ800); // NeoPixel strip3 on GPIO 33
-Preferences preferences;  // Preferences for storing data
+LineReader btLine;       // Bluetooth command being received
+LineReader usbLine;      // USB serial command being received
+Canvas canvas;             // All strips as one logical row of pixels
 WiFiUDP Udp;
+uint8_t ethMac[6];          // Read in ethInit(), identifies the slave to /provision
 
-IPAddress ip, subnet, gateway, outIp;
+IPAddress ip(192, 168, 1, 101);        // Defaults until loadConfig()
+IPAddress subnet(255, 255, 255, 0);
+IPAddress gateway(192, 168, 1, 1);
+IPAddress outIp(192, 168, 1, 99);
 uint16_t inPort = 7001;
 uint16_t outPort = 7000;
+bool dhcp = false;                     // Address by DHCP, the static one above as fallback
+IPAddress leaseIp, leaseSubnet, leaseGateway; // Last DHCP lease, 0.0.0.0 = none
+
+WiFiUDP dmxUdp;              // Art-Net / sACN listener, next to the OSC one
+uint8_t dmxProtocol = DMX_OFF;
+uint16_t dmxUniverse = 0;    // First universe, 0 = same as device_id
+uint16_t dmxStart = 1;       // DMX address of the first pixel's red slot
+uint32_t dmxSyncMillis = 0;  // Last universe sync received
+int dmxGroups = -1;          // Socket holding the sACN groups after the first universe
+LatchClock latchClock;       // Master clock from /time, for timed latches
+uint32_t latchMillis = 0;    // Last /latch received
+bool dither = false;         // 16-bit effect output, dithered down to the strips
+uint32_t powerMa = 0;        // LED supply budget in mA, 0 = unlimited
+uint16_t btWindow = BT_WINDOW_S;
+
+struct StripLayout { int16_t pin; uint16_t count; int16_t clock; }; // clock >= 0 = APA102/SK9822 on SPI
+static_assert(MAX_STRIPS == CONFIG_MAX_STRIPS, "Every strip slot is stored");
+StripLayout layout[MAX_STRIPS] = {  // Loaded with the config, count 0 = slot unused
+  {LED_PIN1, NUM_PIXELS, -1},  // NeoPixel strip1 on GPIO 13
+  {LED_PIN2, NUM_PIXELS, -1},  // NeoPixel strip2 on GPIO 14
+  {LED_PIN3, NUM_PIXELS, -1},  // NeoPixel strip3 on GPIO 33
+  {-1, 0, -1},
+};
+const int8_t LED_PINS_FREE[] = {2, 4, 5, 13, 14, 15, 33}; // Outputs not used by Ethernet, PSRAM, flash or the switch
 
 uint8_t device_id;
 uint32_t lastMillis = 0;
+int32_t pixelSeq = -1;         // Sequence of the last applied delta/keyframe, -1 = none yet
+uint32_t keyRequestMillis = 0;
+volatile bool restartPending = false; // Set by SET_STRIP and a lost link, restarts once the reply and settings are out
+uint32_t restartMillis = 0;
+bool configDirty = false;      // Settings changed since the last write, see saveConfig()
+uint32_t configDirtyMillis = 0;
+uint32_t configChanges = 0;    // saveConfig() calls
+uint32_t configWrites = 0;     // Records written for them
+volatile bool btOn = false;    // SerialBT running, see btClose()
+bool btHeld = false;           // Switch held at power-up, Bluetooth stays on
+uint32_t btOffMillis = 0;      // When Bluetooth was closed
+int32_t btFreed = 0;           // Heap bytes it gave back, as measured
+uint32_t loopPasses = 0;       // loop() passes since loopMillis
+uint32_t loopMillis = 0;
+uint32_t loopRate = 0;         // Passes per second over the last second
+uint32_t loopRateBt = 0;       // The same, last measured with Bluetooth on
+
+// Boot stages in micros() since reset. Ethernet starts first since the link
+// takes longest to come up, the boot animation runs on the effects task and
+// Bluetooth starts on a task of its own, so setup() returns at once and the
+// podium is ready as soon as the link has its address.
+enum BootStage : uint8_t { BOOT_CONFIG, BOOT_ETHERNET, BOOT_LEDS, BOOT_BLUETOOTH, BOOT_LINK, BOOT_STAGES };
+const char* const BOOT_STAGE_NAMES[BOOT_STAGES] = { "config", "ethernet", "leds", "bluetooth", "link" };
+volatile uint32_t bootStartUs[BOOT_STAGES], bootEndUs[BOOT_STAGES]; // End 0 = still running
+uint32_t setupDoneUs = 0;
+bool bootReported = false;
+volatile bool ethReady = false;     // Address assigned, presses can go out
+volatile uint32_t linkUpUs = 0;     // PHY link up, before the address
+uint32_t firstPacketUs = 0;         // First OSC packet received
+bool pressQueued = false;           // Pressed before ethReady, sent once it is
+enum AddressSource : uint8_t { ADDRESS_STATIC, ADDRESS_DHCP, ADDRESS_LEASE, ADDRESS_FALLBACK };
+const char* const ADDRESS_SOURCE_NAMES[] = { "static", "DHCP", "cached lease", "static fallback" };
+volatile AddressSource addressSource = ADDRESS_STATIC;
+volatile bool leaseChanged = false; // DHCP gave an address, cached by cacheLease()
+bool leaseRenewing = false;         // DHCP started under the cached lease by dhcpRenew()
+uint32_t pressesQueued = 0;
+
+void bootStart(BootStage stage) { bootStartUs[stage] = micros(); }
+void bootEnd(BootStage stage) { if (!bootEndUs[stage]) { bootEndUs[stage] = micros(); } }
+
+// Ready to receive: setup() has returned and Ethernet has its address.
+uint32_t bootReadyUs() {
+  uint32_t link = bootEndUs[BOOT_LINK];
+  return link && setupDoneUs ? max(link, setupDoneUs) : 0;
+}
 
-const String HELP = "Available commands:\n"
-                    "SET_IP <ip_address> - Set the device IP address\n"
-                    "SET_SUBNET <subnet_mask> - Set the subnet mask\n"
-                    "SET_GATEWAY <gateway_ip> - Set the gateway IP address\n"
-                    "SET_OUTIP <outgoing_ip> - Set the outgoing IP address\n"
-                    "SET_INPORT <port_number> - Set the input port (default 7001)\n"
-                    "SET_OUTPORT <port_number> - Set the output port (default 7000)\n"
-                    "SET_ID <device_id> - Set the device ID (1-8)\n"
-                    "GET - Get current configuration\n"
-                    "IP - Show current IP address\n"
-                    "MAC - Show current MAC address\n"
-                    "HELP - Show this help message\n";
-
-void saveIPAddress(const char* keyPrefix, IPAddress address) {
-  for (int i = 0; i < 4; i++) {
-    String key = String(keyPrefix) + i;
-    preferences.putUInt(key.c_str(), address[i]);
+bool warmRestart() {
+  esp_reset_reason_t reason = esp_reset_reason();
+  return reason != ESP_RST_POWERON && reason != ESP_RST_EXT && reason != ESP_RST_UNKNOWN;
+}
+
+// Stage lines in ms with one decimal, for the serial log and STATS.
+void getBoot(CommandReply& reply) {
+  uint32_t ready = bootReadyUs();
+  if (ready) { commandPrintf(reply, "Boot: ready in %u.%u ms%s\n", ready / 1000, ready / 100 % 10, warmRestart() ? " (warm restart)" : ""); }
+  else { commandPrint(reply, "Boot: waiting for the Ethernet link\n"); }
+  for (uint8_t s = 0; s < BOOT_STAGES; s++) {
+    uint32_t start = bootStartUs[s], end = bootEndUs[s];
+    if (end) { commandPrintf(reply, "  %-9s at %5u.%u ms, took %5u.%u ms\n", BOOT_STAGE_NAMES[s], start / 1000, start / 100 % 10, (end - start) / 1000, (end - start) / 100 % 10); }
+    else { commandPrintf(reply, "  %-9s at %5u.%u ms, running\n", BOOT_STAGE_NAMES[s], start / 1000, start / 100 % 10); }
+  }
+  if (linkUpUs) {
+    uint32_t latency = linkUpUs - bootStartUs[BOOT_LINK];
+    commandPrintf(reply, "Ethernet: link up at %u.%u ms, %u.%u ms after begin\n", linkUpUs / 1000, linkUpUs / 100 % 10, latency / 1000, latency / 100 % 10);
   }
+  if (firstPacketUs) { commandPrintf(reply, "Ethernet: first packet at %u.%u ms\n", firstPacketUs / 1000, firstPacketUs / 100 % 10); }
+  if (ethReady) { commandPrintf(reply, "Ethernet: address from %s\n", ADDRESS_SOURCE_NAMES[addressSource]); }
+  if (pressesQueued) { commandPrintf(reply, "Ethernet: %u presses held until the address was set\n", pressesQueued); }
 }
 
-IPAddress loadIPAddress(const char* keyPrefix, IPAddress defaultIP) {
-  IPAddress result;
-  for (int i = 0; i < 4; i++) {
-    String key = String(keyPrefix) + i;
-    result[i] = preferences.getUInt(key.c_str(), defaultIP[i]);
+// Dotted quad without the String that IPAddress::toString() allocates.
+struct IPText {
+  char text[16];
+  IPText(const IPAddress& a) { snprintf(text, sizeof(text), "%d.%d.%d.%d", a[0], a[1], a[2], a[3]); }
+};
+
+uint16_t dmxFirstUniverse() { return dmxUniverse ? dmxUniverse : device_id; }
+
+// Pixels in the stored layout; the canvas itself is only built after Ethernet.
+uint16_t layoutPixels() {
+  uint16_t total = 0;
+  for (const auto& segment : layout) { total += segment.count; }
+  return total;
+}
+
+void getConfig(CommandReply& reply) {
+  commandPrintf(reply, "Device ID: %d\n",  device_id);
+  commandPrintf(reply, "IP: %s\n",         IPText(ip).text);
+  commandPrintf(reply, "Subnet: %s\n",     IPText(subnet).text);
+  commandPrintf(reply, "Gateway: %s\n",    IPText(gateway).text);
+  commandPrintf(reply, "Address: %s\n",    dhcp ? "DHCP, the IP above as fallback" : "static");
+  commandPrintf(reply, "Out IP: %s\n",     IPText(outIp).text);
+  commandPrintf(reply, "In Port: %d\n",    inPort);
+  commandPrintf(reply, "Out Port: %d\n",   outPort);
+  commandPrintf(reply, "DMX: %s, universe %d, start %d\n", dmxProtocolName(dmxProtocol), dmxFirstUniverse(), dmxStart);
+  commandPrintf(reply, "Dither: %s\n",    dither ? "on" : "off");
+  commandPrintf(reply, "Power budget: %u mA\n", powerMa);
+  if (btWindow) { commandPrintf(reply, "Bluetooth window: %u s after boot\n", btWindow); }
+  else { commandPrint(reply, "Bluetooth window: always on\n"); }
+  for (uint8_t s = 0; s < MAX_STRIPS; s++) {
+    if (!layout[s].count) { continue; }
+    if (layout[s].clock >= 0) { commandPrintf(reply, "Strip %d: APA102 data GPIO %d, clock GPIO %d, %d LEDs\n", s + 1, layout[s].pin, layout[s].clock, layout[s].count); }
+    else { commandPrintf(reply, "Strip %d: GPIO %d, %d LEDs\n", s + 1, layout[s].pin, layout[s].count); }
   }
-  return result;
+  commandPrintf(reply, "Animations: %d", animClipCount(animData()));
+  for (uint16_t c = 0; c < animClipCount(animData()); c++) { commandPrintf(reply, "%s%.16s", c ? ", " : " (", animClipName(animData(), c)); }
+  commandPrint(reply, animClipCount(animData()) ? ")\n" : "\n");
 }
 
-void getConfig() {
-  SerialBT.printf("Device ID: %d\n",  device_id);
-  SerialBT.printf("IP: %s\n",         ip.toString().c_str());
-  SerialBT.printf("Subnet: %s\n",     subnet.toString().c_str());
-  SerialBT.printf("Gateway: %s\n",    gateway.toString().c_str());
-  SerialBT.printf("Out IP: %s\n",     outIp.toString().c_str());
-  SerialBT.printf("In Port: %d\n",    inPort);
-  SerialBT.printf("Out Port: %d\n",   outPort);
+bool ledPinFree(int pin) {
+  for (int8_t p : LED_PINS_FREE) { if (p == pin) { return true; } }
+  return false;
 }
 
-void saveNetworkConfig() {
-  preferences.begin("CONFIG", false);
-  saveIPAddress("ip", ip);
-  saveIPAddress("sub", subnet);
-  saveIPAddress("gw", gateway);
-  saveIPAddress("out", outIp);
-  preferences.putUInt("inPort", inPort); // Save input port
-  preferences.putUInt("outPort", outPort); // Save output port
-  preferences.end();
+// Whether a strip layout can be driven: free output pins, none shared, the
+// LEDs within what the engine renders and no more clocked strips than buses.
+bool stripsValid(const DeviceConfig& config) {
+  uint32_t total = 0;
+  uint8_t clocked = 0;
+  for (uint8_t s = 0; s < MAX_STRIPS; s++) {
+    const ConfigStrip& strip = config.strips[s];
+    if (!strip.count) { continue; }
+    total += strip.count;
+    if (!ledPinFree(strip.pin)) { return false; }
+    if (strip.clock >= 0 && (++clocked > CLOCKED_MAX_BUSES || strip.clock == strip.pin || !ledPinFree(strip.clock))) { return false; }
+    for (uint8_t t = 0; t < s; t++) {
+      const ConfigStrip& other = config.strips[t];
+      if (!other.count) { continue; }
+      if (other.pin == strip.pin || other.pin == strip.clock || (other.clock >= 0 && (other.clock == strip.pin || other.clock == strip.clock))) { return false; }
+    }
+  }
+  return total <= EFFECTS_MAX_PIXELS;
 }
 
-void loadConfig() {
-  preferences.begin("CONFIG", true);
-  device_id = preferences.getUInt("device_id", 0); // Load device ID
-  if (device_id < 1 || device_id > 8) {
-    device_id = 10; // Default to 1 if invalid
-    preferences.putUInt("device_id", device_id); // Save default device ID
+// The settings live in the globals above; the stored record is only
+// built to save them, see config.h.
+DeviceConfig packConfig() {
+  DeviceConfig config = {};
+  config.deviceId    = device_id;
+  config.dmxProtocol = dmxProtocol;
+  config.dither      = dither;
+  config.dhcp        = dhcp;
+  for (uint8_t i = 0; i < 4; i++) {
+    config.ip[i]      = ip[i];
+    config.subnet[i]  = subnet[i];
+    config.gateway[i] = gateway[i];
+    config.outIp[i]   = outIp[i];
+    config.leaseIp[i]      = leaseIp[i];
+    config.leaseSubnet[i]  = leaseSubnet[i];
+    config.leaseGateway[i] = leaseGateway[i];
+  }
+  config.inPort      = inPort;
+  config.outPort     = outPort;
+  config.dmxUniverse = dmxUniverse;
+  config.dmxStart    = dmxStart;
+  config.powerMa     = powerMa;
+  config.btWindow    = btWindow;
+  for (uint8_t s = 0; s < MAX_STRIPS; s++) { config.strips[s] = { (int8_t)layout[s].pin, (int8_t)layout[s].clock, layout[s].count }; }
+  return config;
+}
+
+void unpackConfig(const DeviceConfig& config) {
+  device_id   = config.deviceId;
+  dmxProtocol = config.dmxProtocol;
+  dither      = config.dither;
+  dhcp        = config.dhcp;
+  ip          = IPAddress(config.ip[0], config.ip[1], config.ip[2], config.ip[3]);
+  subnet      = IPAddress(config.subnet[0], config.subnet[1], config.subnet[2], config.subnet[3]);
+  gateway     = IPAddress(config.gateway[0], config.gateway[1], config.gateway[2], config.gateway[3]);
+  outIp       = IPAddress(config.outIp[0], config.outIp[1], config.outIp[2], config.outIp[3]);
+  leaseIp      = IPAddress(config.leaseIp[0], config.leaseIp[1], config.leaseIp[2], config.leaseIp[3]);
+  leaseSubnet  = IPAddress(config.leaseSubnet[0], config.leaseSubnet[1], config.leaseSubnet[2], config.leaseSubnet[3]);
+  leaseGateway = IPAddress(config.leaseGateway[0], config.leaseGateway[1], config.leaseGateway[2], config.leaseGateway[3]);
+  inPort      = config.inPort;
+  outPort     = config.outPort;
+  dmxUniverse = config.dmxUniverse;
+  dmxStart    = config.dmxStart;
+  powerMa     = config.powerMa;
+  btWindow    = config.btWindow;
+  for (uint8_t s = 0; s < MAX_STRIPS; s++) { layout[s] = { config.strips[s].pin, config.strips[s].count, config.strips[s].clock }; }
+}
+
+// Changes are only marked here. flushConfig() writes them all as one record
+// once CONFIG_QUIET_MS pass without another, on SAVE and before a restart,
+// so a tool scripting many SET_ commands costs one flash write, not one each.
+void saveConfig() {
+  configDirty = true;
+  configDirtyMillis = millis();
+  configChanges++;
+}
+
+bool flushConfig() {
+  if (!configDirty) { return true; }
+  DeviceConfig config = packConfig();
+  if (!configSave(config)) {
+    Serial.println("ERROR: Could not save the configuration");
+    configDirtyMillis = millis();  // Tried again after another quiet period
+    return false;
   }
-  preferences.end();
-  if (DEBUG) { Serial.println("Device ID: " + String(device_id)); }
+  configDirty = false;
+  configWrites++;
+  return true;
+}
+
+void flushConfigWhenQuiet() {
+  if (configDirty && millis() - configDirtyMillis >= CONFIG_QUIET_MS) { flushConfig(); }
+}
+
+// Settings are written before the restart that applies them. A failed write
+// is tried again; after RESTART_SAVE_TRIES the restart goes ahead anyway,
+// with the stored settings, rather than keep a slave with a lost link up.
+void restartWhenDue() {
+  static uint8_t tries = 0;
+  if (!restartPending || millis() - restartMillis < RESTART_DELAY_MS) { return; }
+  if (!flushConfig() && ++tries < RESTART_SAVE_TRIES) {
+    restartMillis = millis();     // Another try after RESTART_DELAY_MS
+    return;
+  }
+  if (configDirty) { Serial.println("ERROR: Restarting without the unsaved settings"); }
+  ESP.restart();
+}
+
+// One read for every setting, before anything that depends on them starts.
+void loadConfig() {
+  static const char* const SOURCES[] = { "saved record", "old keys, migrated", "defaults" };
+  DeviceConfig config = packConfig();              // Compiled-in defaults
+  ConfigSource source = configLoad(config);
+  unpackConfig(config);
+  if (device_id < 1 || device_id > 8) { device_id = 10; } // Not set yet, matches no podium
+  if (DEBUG) { Serial.printf("Device ID: %d, settings from %s\n", device_id, SOURCES[source]); }
 }
 
-void loadNetworkConfig() {
-  preferences.begin("CONFIG", true);
-  ip      = loadIPAddress("ip",  IPAddress(192, 168, 1, 101));
-  subnet  = loadIPAddress("sub", IPAddress(255, 255, 255, 0));
-  gateway = loadIPAddress("gw",  IPAddress(192, 168, 1, 1  ));
-  outIp   = loadIPAddress("out", IPAddress(192, 168, 1, 99 ));
-  inPort  = preferences.getUInt("inPort", 7001); // Load input port
-  outPort = preferences.getUInt("outPort", 7000); // Load output port
-  preferences.end();
+// Settings that configure modules started after loadConfig().
+void applyConfig() {
+  effectsSetDither(dither);
+  canvas.setPowerBudget(powerMa);
+}
+
+uint32_t idleColor() {
+  return (device_id <= 4) ? Adafruit_NeoPixel::Color(BLUE) : Adafruit_NeoPixel::Color(MAGENTA);
+}
+
+// Anything but a delta overwrites the frame /pixels/delta builds on, so the
+// next delta waits for a keyframe rather than draw on top of something else.
+void dropPixelBase() { pixelSeq = -1; }
+
+// While the master sends latches, frames and colour commands are staged and
+// only shown by the next /latch, see latch.h. stageFrame() goes before any
+// change to the canvas or the effects, frameDone() after a canvas write.
+bool latchMode() { return latchMillis && millis() - latchMillis < LATCH_MODE_TIMEOUT_MS; }
+void stageFrame() {
+  dropPixelBase();                 // Set again by a delta once it is applied
+  if (latchMode()) { effectsHold(); }
+}
+void frameDone() { if (!latchMode()) { effectsKick(); } }
+
+void getStats(CommandReply& reply) {
+  EffectStats stats = effectsGetStats();
+  commandPrintf(reply, "Frames: %u\n",        stats.frames);
+  commandPrintf(reply, "Frame us: last %u, min %u, avg %u, max %u\n", stats.lastUs, stats.minUs, stats.avgUs, stats.maxUs);
+  commandPrintf(reply, "Overruns: %u\n",      stats.overruns);
+  commandPrintf(reply, "Rate: %d fps%s\n",     effectsDithering() ? DITHER_FPS : EFFECTS_FPS, effectsDithering() ? " (dithering)" : "");
+  commandPrintf(reply, "Heap: %u free, PSRAM: %u free\n", ESP.getFreeHeap(), ESP.getFreePsram());
+  getBoot(reply);
+  for (uint8_t s = 0; s < canvas.segmentCount(); s++) {
+    if (canvas.clockedSegment(s)) { commandPrintf(reply, "SPI frame, segment %d: %u us\n", s + 1, canvas.clockedSegment(s)->frameMicros()); }
+  }
+  commandPrintf(reply, "Power: %u mA estimated, budget %u mA, output at %u%%\n",
+                       canvas.estimateMilliamps(), canvas.powerBudget(), canvas.powerScale() * 100 / 256);
+  commandPrintf(reply, "Latch: %u shown, latest %u us late, %u timed out%s\n", stats.latches, stats.latchLateUs, stats.holdTimeouts, latchMode() ? "" : " (not in use)");
+  if (latchClock.valid) { commandPrintf(reply, "Master clock: offset %d us, drift %d ppb\n", latchClock.offsetUs, latchClock.driftPpb); }
+  else { commandPrint(reply, "Master clock: not synced\n"); }
+  if (btOn) { commandPrintf(reply, "Bluetooth: on%s\n", btHeld ? ", switch held at boot" : btWindow ? "" : ", no window set"); }
+  else { commandPrintf(reply, "Bluetooth: off since %u s, heap %+d bytes\n", btOffMillis / 1000, btFreed); }
+  commandPrintf(reply, "Config: %u changes in %u writes%s\n", configChanges, configWrites, configDirty ? ", unsaved changes pending" : "");
+  if (btLine.dropped) { commandPrintf(reply, "Bluetooth: %u lines over %d characters dropped\n", btLine.dropped, LINE_READER_SIZE - 1); }
+  if (btOn) { commandPrintf(reply, "Loop: %u passes/s\n", loopRate); }
+  else { commandPrintf(reply, "Loop: %u passes/s, %u with Bluetooth on\n", loopRate, loopRateBt); }
 }
 
 void oscSend(int value) {
@@ -126,100 +385,625 @@ void oscSend(int value) {
 void processOSCData(uint8_t data_In){
   if (DEBUG) { Serial.printf("Processing OSC Data: %d\n", data_In); }
   if (data_In == device_id) {
-    for (auto& strip : {&strip1, &strip2, &strip3}) {
-      strip->setBrightness(255);          // Set brightness to maximum (0-255)
-      strip->fill(strip->Color(RED)); // Set NeoPixel strip to MAGENTA
-      strip->show();                      // Update the strip to show the new color
-    }
+    stageFrame();
+    effectsStop();
+    effectsSetBase(FRAME_HIT); // Red at full brightness until cleared
   }
 }
 
-void oscReceive() {
-  int packetSize = Udp.parsePacket(); // Check if a packet is available
-  if (packetSize > 0) {
-    OSCMessage msgIn;
-    while (packetSize--) { msgIn.fill(Udp.read()); }  // Fill the OSCMessage with incoming data 
-    if (msgIn.fullMatch("/device/")) {                // Check if the address matches "/device/"
-      int data = msgIn.getInt(0);                     // Get the integer value from the first argument
-      processOSCData(data);
-      if (DEBUG) {Serial.printf("Received OSC message: Address = /device/, Value = %d\n", data);}
-    } else if (msgIn.fullMatch("/clear/")){
-      for (auto& strip : {&strip1, &strip2, &strip3}) {
-          strip->clear(); // Clear the NeoPixel strip
-          strip->setBrightness(128); // Set brightness to 50 (0-255)
-          if (device_id <= 4){strip->fill(strip->Color(BLUE)); } // Fill the strip with blue color
-          else if (device_id > 4) {strip->fill(strip->Color(MAGENTA));}
-          strip->show(); // Update the strip to show the cleared state
-      }
-      if (DEBUG) {Serial.println("Received OSC message: /clear/ - NeoPixel strip1 cleared.");}
-    } else { Serial.println("Received OSC message with unmatched address."); }
-    msgIn.empty(); // Clear the message after processing
+// "/pixels <blob RGB...> [offset] [strip]" - decoded straight from the packet into
+// the canvas, without the blob copy OSCMessage would make. Offset is in pixels,
+// relative to the start of `strip` if given, else to the whole canvas.
+void oscReceivePixels(const OSCView& view) {
+  const uint8_t* rgb;
+  uint32_t bytes;
+  int32_t offset = 0, strip = -1;
+  if (!oscViewBlob(view, 0, rgb, bytes)) { return; }
+  oscViewInt(view, 1, offset);
+  oscViewInt(view, 2, strip);
+  uint32_t count = bytes / 3;
+  if (strip >= 0) {
+    if (strip >= canvas.segmentCount() || offset < 0) { return; }
+    uint16_t length = canvas.segment(strip).numPixels();
+    if ((uint32_t)offset >= length) { return; }
+    count = min<uint32_t>(count, length - offset); // Stay inside the strip
+    offset += canvas.segmentStart(strip);
   }
+  if (offset < 0 || offset >= canvas.numPixels()) { return; }
+  stageFrame();
+  effectsDirect();
+  effectsLockCanvas();
+  canvas.write(offset, rgb, min<uint32_t>(count, canvas.numPixels() - offset));
+  effectsUnlockCanvas();
+  frameDone();
 }
 
-void processData(String data) {
-  data.trim(); // Remove leading and trailing whitespace
-  auto updateIP = [&](const String& prefix, IPAddress& target, int offset) {
-    String value = data.substring(offset);
-    if (target.fromString(value)) {
-      saveNetworkConfig();
-      SerialBT.printf("✅ %s updated and saved.\n", prefix.c_str());
-    } else {
-      SerialBT.printf("❌ Invalid %s format.\n", prefix.c_str());
-    }
-  };
-  if (data.startsWith("SET_IP ")) { updateIP("IP", ip, 7); } 
-  else if (data.startsWith("SET_SUBNET ")) { updateIP("Subnet", subnet, 11); } 
-  else if (data.startsWith("SET_GATEWAY ")) { updateIP("Gateway", gateway, 12);  } 
-  else if (data.startsWith("SET_OUTIP ")) { updateIP("OutIP", outIp, 10); } 
-  else if (data.startsWith ("SET_INPORT ")) {
-    int port = data.substring(10).toInt();
-    if (port > 0 && port < 65536) { inPort = static_cast<uint16_t>(port); saveNetworkConfig(); SerialBT.printf("✅ Input port set to %d and saved.\n", inPort); } 
-    else { SerialBT.println("❌ Invalid port. Must be between 1 and 65535."); }
+void requestKeyframe() {
+  if (millis() - keyRequestMillis < KEYFRAME_RETRY_MS) { return; } // Don't flood the master while waiting
+  keyRequestMillis = millis();
+  OSCMessage msg("/pixels/keyreq");
+  msg.add((int32_t)device_id);
+  msg.add((int32_t)pixelSeq);
+  Udp.beginPacket(outIp, outPort);
+  msg.send(Udp);
+  Udp.endPacket();
+  if (DEBUG) { Serial.printf("Requested keyframe after sequence %d\n", pixelSeq); }
+}
+
+// "/pixels/key <seq> <blob ops>" and "/pixels/delta <seq> <blob ops>" - see
+// pixel_delta.h. A keyframe starts from black, a delta from the last frame; a
+// gap in the sequence, or any other write since (see dropPixelBase()), drops
+// the delta and asks the master for a keyframe.
+void oscReceivePixelOps(const OSCView& view, bool keyframe) {
+  int32_t seq;
+  const uint8_t* ops;
+  uint32_t bytes;
+  if (!oscViewInt(view, 0, seq) || !oscViewBlob(view, 1, ops, bytes)) { return; }
+  if (!keyframe && (pixelSeq < 0 || (uint16_t)seq != (uint16_t)(pixelSeq + 1))) { requestKeyframe(); return; }
+  if (!pixelDeltaValid(ops, bytes, canvas.numPixels())) { requestKeyframe(); return; }
+  stageFrame();
+  effectsDirect();
+  effectsLockCanvas();
+  if (keyframe) { canvas.clear(); }
+  pixelDeltaApply(canvas, ops, bytes);     // Runs go straight into the framebuffer
+  effectsUnlockCanvas();
+  pixelSeq = (uint16_t)seq;
+  frameDone();
+}
+
+// "/time <master_us>" and "/latch [master_us]" - see latch.h. `arrivedUs` is
+// taken as soon as the packet is seen, so the clock samples carry as little
+// of the loop's own delay as possible.
+void oscReceiveTime(const OSCView& view, uint32_t arrivedUs) {
+  int32_t masterUs;
+  if (oscViewInt(view, 0, masterUs)) { latchClockSample(latchClock, masterUs, arrivedUs); }
+}
+
+void oscReceiveLatch(const OSCView& view, uint32_t arrivedUs) {
+  int32_t masterUs;
+  uint32_t at = arrivedUs;                          // No time given: show now
+  if (oscViewInt(view, 0, masterUs) && latchClock.valid) {
+    at = latchClockToLocal(latchClock, masterUs);
+    int32_t ahead = (int32_t)(at - micros());
+    if (ahead < 0 || ahead > LATCH_MAX_AHEAD_US) { at = micros(); } // Already due, or a clock jump
   }
-  else if (data.startsWith("SET_OUTPORT ")) {
-    int port = data.substring(12).toInt();
-    if (port > 0 && port < 65536) { outPort = static_cast<uint16_t>(port); saveNetworkConfig(); SerialBT.printf("✅ Output port set to %d and saved.\n", outPort); } 
-    else { SerialBT.println("❌ Invalid port. Must be between 1 and 65535."); }
-  }  
-  else if (data.startsWith("SET_ID ")) {
-    int id = data.substring(7).toInt();
-    if (id >= 1 && id <= 8) {
-      device_id = static_cast<uint8_t>(id);
-      preferences.begin("CONFIG", false);
-      preferences.putUInt("device_id", device_id);
-      preferences.end();
-      SerialBT.printf("✅ Device ID set to %d and saved.\n", device_id);
-    } else {
-      SerialBT.println("❌ Invalid Device ID. Must be between 1 and 8.");
+  latchMillis = millis();
+  effectsLatch(at);
+}
+
+// sACN sends every universe to its own group, 239.255.<universe>. dmxUdp joins
+// the first one; the groups of the other universes the canvas spans are joined
+// on a socket that is never read, and lwIP hands their packets to dmxUdp like
+// any datagram for the port. Closing the socket leaves the groups again.
+void dmxJoinUniverses() {
+  if (dmxGroups >= 0) { close(dmxGroups); }
+  dmxGroups = -1;
+  if (dmxProtocol != DMX_SACN) { return; }
+  uint16_t first = dmxFirstUniverse(), firstPixel, firstSlot;
+  for (uint16_t universe = first + 1; dmxMapUniverse(first, dmxStart, universe, firstPixel, firstSlot) && firstPixel < layoutPixels(); universe++) {
+    if (dmxGroups < 0) { dmxGroups = socket(AF_INET, SOCK_DGRAM, 0); }
+    ip_mreq group = {};
+    group.imr_multiaddr.s_addr = (uint32_t)IPAddress(239, 255, universe >> 8, universe & 0xFF);
+    group.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (dmxGroups < 0 || setsockopt(dmxGroups, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+      Serial.printf("sACN: cannot join the group of universe %d, send it unicast\n", universe); // lwIP's group table is full
     }
   }
-  else if (data == "GET") { getConfig(); }
-  else if (data == "IP") { SerialBT.printf("ETH IP: %s\n", ETH.localIP().toString().c_str());}
-  else if (data == "MAC") { SerialBT.printf("ETH MAC: %s\n", ETH.macAddress().c_str());}
-  else if (data.indexOf("HELP")>=0){
-    SerialBT.println(HELP);
-    Serial.println(HELP);
+}
+
+void dmxBegin() {
+  dmxUdp.stop();
+  if (dmxProtocol == DMX_ARTNET) { dmxUdp.begin(ARTNET_PORT); }
+  else if (dmxProtocol == DMX_SACN) {
+    uint16_t universe = dmxFirstUniverse();
+    dmxUdp.beginMulticast(IPAddress(239, 255, universe >> 8, universe & 0xFF), E131_PORT); // Unicast to our IP works too
+  }
+  dmxJoinUniverses();
+}
+
+void dmxReceive() {
+  static uint8_t packet[DMX_PACKET_SIZE];
+  if (dmxProtocol == DMX_OFF) { return; }
+  int packetSize = dmxUdp.parsePacket();
+  if (packetSize <= 0) { return; }
+  packetSize = dmxUdp.read(packet, min(packetSize, DMX_PACKET_SIZE));
+  DmxPacket dmx;
+  DmxKind kind = (dmxProtocol == DMX_ARTNET) ? artnetDecode(packet, packetSize, dmx) : e131Decode(packet, packetSize, dmx);
+  if (kind == DMX_SYNC) {
+    dmxSyncMillis = millis();
+    effectsKick();                                   // One coordinated show for all universes
+    return;
+  }
+  uint16_t firstPixel, firstSlot;
+  if (kind != DMX_DATA || !dmxMapUniverse(dmxFirstUniverse(), dmxStart, dmx.universe, firstPixel, firstSlot)) { return; }
+  if (firstPixel >= canvas.numPixels() || firstSlot >= dmx.count) { return; }
+  uint16_t count = min<uint32_t>((dmx.count - firstSlot) / 3, canvas.numPixels() - firstPixel);
+  dropPixelBase();
+  effectsDirect();
+  effectsLockCanvas();
+  canvas.write(firstPixel, dmx.slots + firstSlot, count); // Slots go from the packet straight into the framebuffer
+  effectsUnlockCanvas();
+  bool synced = dmx.waitForSync || (dmxSyncMillis && millis() - dmxSyncMillis < DMX_SYNC_TIMEOUT_MS);
+  if (!synced) { effectsKick(); }                  // No sync in use, show every universe as it arrives
+}
+
+// Takes a checked config and applies whatever the changed fields need; the
+// record is marked for one NVS write by flushConfig(). New network settings
+// are applied by a restart if `restartForNetwork` (provisioning), else at
+// the next one. Returns what happens next, for the reply.
+const char* changeConfig(const DeviceConfig& next, bool restartForNetwork) {
+  DeviceConfig prev = packConfig();
+  unpackConfig(next);
+  saveConfig();
+  if (next.deviceId != prev.deviceId) { effectsDefineFrame(FRAME_IDLE, idleColor(), 128); } // Idle colour follows the ID
+  if (next.dither != prev.dither) { effectsSetDither(dither); }
+  if (next.powerMa != prev.powerMa) { canvas.setPowerBudget(powerMa); }
+  if (next.dmxProtocol != prev.dmxProtocol || next.dmxUniverse != prev.dmxUniverse || next.dmxStart != prev.dmxStart || (next.deviceId != prev.deviceId && !dmxUniverse)) { dmxBegin(); }
+  bool network = memcmp(next.ip, prev.ip, 4) || memcmp(next.subnet, prev.subnet, 4) || memcmp(next.gateway, prev.gateway, 4) || next.inPort != prev.inPort || next.dhcp != prev.dhcp;
+  if (memcmp(next.strips, prev.strips, sizeof(next.strips)) || (network && restartForNetwork)) {
+    restartPending = true;        // The canvas layout is fixed once begun, the network set up once
+    restartMillis = millis();
+    return "will be saved, restarting";
+  }
+  return network ? "will be saved, network settings apply after a restart" : "will be saved";
+}
+
+// Command handlers, see command.h. Arguments arrive counted by the table,
+// so each one only checks their values. Settings go through changeConfig()
+// like /config/set, so a field has the same effect whichever way it is set.
+void setAddress(const CommandArgs& args, CommandReply& reply, uint8_t (DeviceConfig::*field)[4], const char* label) {
+  DeviceConfig next = packConfig();
+  if (!commandArgIp(args, 0, next.*field)) { commandPrintf(reply, "❌ Invalid %s format.\n", label); return; }
+  commandPrintf(reply, "✅ %s updated, %s.\n", label, changeConfig(next, false));
+}
+
+void setPort(const CommandArgs& args, CommandReply& reply, uint16_t DeviceConfig::*field, const char* label) {
+  long port;
+  if (!commandArgInt(args, 0, 1, 65535, port)) { commandPrint(reply, "❌ Invalid port. Must be between 1 and 65535.\n"); return; }
+  DeviceConfig next = packConfig();
+  next.*field = port;
+  commandPrintf(reply, "✅ %s port set to %ld, %s.\n", label, port, changeConfig(next, false));
+}
+
+void cmdSetIp(const CommandArgs& args, CommandReply& reply)      { setAddress(args, reply, &DeviceConfig::ip, "IP"); }
+void cmdSetSubnet(const CommandArgs& args, CommandReply& reply)  { setAddress(args, reply, &DeviceConfig::subnet, "Subnet"); }
+void cmdSetGateway(const CommandArgs& args, CommandReply& reply) { setAddress(args, reply, &DeviceConfig::gateway, "Gateway"); }
+void cmdSetOutIp(const CommandArgs& args, CommandReply& reply)   { setAddress(args, reply, &DeviceConfig::outIp, "OutIP"); }
+void cmdSetInPort(const CommandArgs& args, CommandReply& reply)  { setPort(args, reply, &DeviceConfig::inPort, "Input"); }
+void cmdSetOutPort(const CommandArgs& args, CommandReply& reply) { setPort(args, reply, &DeviceConfig::outPort, "Output"); }
+
+void cmdSetId(const CommandArgs& args, CommandReply& reply) {
+  long id;
+  if (!commandArgInt(args, 0, 1, 8, id)) { commandPrint(reply, "❌ Invalid Device ID. Must be between 1 and 8.\n"); return; }
+  DeviceConfig next = packConfig();
+  next.deviceId = id;
+  commandPrintf(reply, "✅ Device ID set to %ld, %s.\n", id, changeConfig(next, false));
+}
+
+void cmdSetDmx(const CommandArgs& args, CommandReply& reply) {
+  uint8_t protocol = commandArgIs(args, 0, "artnet") ? DMX_ARTNET : commandArgIs(args, 0, "sacn") ? DMX_SACN : commandArgIs(args, 0, "off") ? DMX_OFF : 0xFF;
+  long universe = 0, start = 1;
+  if (protocol == 0xFF || (args.count > 1 && !commandArgInt(args, 1, 0, 32767, universe)) || (args.count > 2 && !commandArgInt(args, 2, 1, DMX_SLOTS, start))) {
+    commandPrint(reply, "❌ Invalid DMX settings. Use off, artnet or sacn, universe 0-32767, start 1-512.\n");
     return;
-  } else if (data.indexOf("GET")>=0){
-    getConfig();
+  }
+  DeviceConfig next = packConfig();
+  next.dmxProtocol = protocol;
+  next.dmxUniverse = universe;
+  next.dmxStart = start;
+  const char* result = changeConfig(next, false);
+  commandPrintf(reply, "✅ DMX set to %s, universe %d, start %d, %s.\n", dmxProtocolName(dmxProtocol), dmxFirstUniverse(), dmxStart, result);
+}
+
+void cmdSetDhcp(const CommandArgs& args, CommandReply& reply) {
+  long on;
+  if (!commandArgInt(args, 0, 0, 1, on)) { commandPrint(reply, "❌ Invalid value. Use 0 or 1.\n"); return; }
+  DeviceConfig next = packConfig();
+  next.dhcp = on;
+  commandPrintf(reply, "✅ %s, %s.\n", on ? "DHCP on, the static IP is the fallback" : "DHCP off", changeConfig(next, false));
+}
+
+void cmdSetDither(const CommandArgs& args, CommandReply& reply) {
+  long on;
+  if (!commandArgInt(args, 0, 0, 1, on)) { commandPrint(reply, "❌ Invalid value. Use 0 or 1.\n"); return; }
+  DeviceConfig next = packConfig();
+  next.dither = on;
+  commandPrintf(reply, "✅ Dithering %s, %s.\n", on ? "on" : "off", changeConfig(next, false));
+}
+
+void cmdSetStrip(const CommandArgs& args, CommandReply& reply) {
+  long slot, pin, count, clock = -1;
+  DeviceConfig next = packConfig();
+  bool ok = commandArgInt(args, 0, 1, MAX_STRIPS, slot) && commandArgInt(args, 1, -1, 39, pin) &&
+            commandArgInt(args, 2, 0, EFFECTS_MAX_PIXELS, count) && (args.count < 4 || commandArgInt(args, 3, 0, 39, clock));
+  if (ok) {
+    if (count == 0) { pin = clock = -1; }
+    next.strips[slot - 1] = { static_cast<int8_t>(pin), static_cast<int8_t>(clock), static_cast<uint16_t>(count) };
+    ok = stripsValid(next);
+  }
+  if (!ok) {
+    commandPrintf(reply, "❌ Invalid strip settings. Use slot 1-%d, free output pins (2, 4, 5, 13, 14, 15, 33), at most %d LEDs in total and %d clocked strips.\n", MAX_STRIPS, EFFECTS_MAX_PIXELS, CLOCKED_MAX_BUSES);
     return;
   }
+  const char* result = changeConfig(next, false); // Restarts if the layout changed, it is fixed once begun
+  if (clock >= 0) { commandPrintf(reply, "✅ Strip %ld set to APA102 on GPIO %ld, clock GPIO %ld, %ld LEDs, %s.\n", slot, pin, clock, count, result); }
+  else { commandPrintf(reply, "✅ Strip %ld set to GPIO %ld, %ld LEDs, %s.\n", slot, pin, count, result); }
+}
+
+void cmdSetPower(const CommandArgs& args, CommandReply& reply) {
+  long mA;
+  if (!commandArgInt(args, 0, 0, 100000, mA)) { commandPrint(reply, "❌ Invalid power budget. Must be between 0 and 100000 mA.\n"); return; }
+  DeviceConfig next = packConfig();
+  next.powerMa = mA;
+  commandPrintf(reply, "✅ Power budget set to %ld mA, %s.\n", mA, changeConfig(next, false));
+}
+
+void cmdSetBtWindow(const CommandArgs& args, CommandReply& reply) {
+  long seconds;
+  if (!commandArgInt(args, 0, 0, 65535, seconds)) { commandPrint(reply, "❌ Invalid window. Must be between 0 and 65535 seconds.\n"); return; }
+  DeviceConfig next = packConfig();
+  next.btWindow = seconds;
+  const char* result = changeConfig(next, false);
+  if (seconds) { commandPrintf(reply, "✅ Bluetooth window set to %ld s after boot, %s.\n", seconds, result); }
+  else { commandPrintf(reply, "✅ Bluetooth set to stay on, %s.\n", result); }
+}
+
+void cmdSave(const CommandArgs& args, CommandReply& reply) {
+  if (!configDirty) { commandPrint(reply, "✅ Nothing to save.\n"); return; }
+  if (flushConfig()) { commandPrint(reply, "✅ Configuration saved.\n"); }
+  else { commandPrint(reply, "❌ Could not save the configuration.\n"); }
+}
+
+void cmdGet(const CommandArgs& args, CommandReply& reply)   { getConfig(reply); }
+void cmdStats(const CommandArgs& args, CommandReply& reply) { getStats(reply); }
+void cmdIp(const CommandArgs& args, CommandReply& reply)    { commandPrintf(reply, "ETH IP: %s (%s)\n", IPText(ETH.localIP()).text, ADDRESS_SOURCE_NAMES[addressSource]); }
+
+void cmdMac(const CommandArgs& args, CommandReply& reply) {
+  char mac[FLEET_MAC_TEXT];
+  fleetMacText(ethMac, mac);
+  commandPrintf(reply, "ETH MAC: %s\n", mac);
+}
+
+void cmdHelp(const CommandArgs& args, CommandReply& reply);
+
+const Command COMMANDS[] = {
+  COMMAND("SET_IP",      1, 1, cmdSetIp,      "<ip_address>",   "Set the device IP address"),
+  COMMAND("SET_SUBNET",  1, 1, cmdSetSubnet,  "<subnet_mask>",  "Set the subnet mask"),
+  COMMAND("SET_GATEWAY", 1, 1, cmdSetGateway, "<gateway_ip>",   "Set the gateway IP address"),
+  COMMAND("SET_OUTIP",   1, 1, cmdSetOutIp,   "<outgoing_ip>",  "Set the outgoing IP address"),
+  COMMAND("SET_INPORT",  1, 1, cmdSetInPort,  "<port_number>",  "Set the input port (default 7001)"),
+  COMMAND("SET_OUTPORT", 1, 1, cmdSetOutPort, "<port_number>",  "Set the output port (default 7000)"),
+  COMMAND("SET_DHCP",    1, 1, cmdSetDhcp,    "<0|1>",          "Address by DHCP, the static IP as fallback (applies after a restart)"),
+  COMMAND("SET_ID",      1, 1, cmdSetId,      "<device_id>",    "Set the device ID (1-8)"),
+  COMMAND("SET_DMX",     1, 3, cmdSetDmx,     "<off|artnet|sacn> [universe] [start]", "DMX input (universe 0 = device ID)"),
+  COMMAND("SET_DITHER",  1, 1, cmdSetDither,  "<0|1>",          "Temporal dithering for smooth low-level fades"),
+  COMMAND("SET_STRIP",   3, 4, cmdSetStrip,   "<1-4> <pin> <count> [clock pin]",
+          "Strip output pin and length (count 0 = unused), restarts\n  With a clock pin the strip is APA102/SK9822 on SPI (at most 2)"),
+  COMMAND("SET_POWER",   1, 1, cmdSetPower,   "<mA>",           "LED power budget, output is dimmed to stay under it (0 = unlimited)"),
+  COMMAND("SET_BT_WINDOW", 1, 1, cmdSetBtWindow, "<seconds>",    "Bluetooth only this long after boot, then off to free memory (0 = always on)\n  Holding the switch at power-up keeps it on until the next restart"),
+  COMMAND("SAVE",        0, 0, cmdSave,       "",               "Write changed settings now (otherwise 2 s after the last change)"),
+  COMMAND("GET",         0, 0, cmdGet,        "",               "Get current configuration"),
+  COMMAND("IP",          0, 0, cmdIp,         "",               "Show current IP address"),
+  COMMAND("MAC",         0, 0, cmdMac,        "",               "Show current MAC address"),
+  COMMAND("STATS",       0, 0, cmdStats,      "",               "Show LED frame timing statistics"),
+  COMMAND("HELP",        0, 0, cmdHelp,       "",               "Show this help message"),
+};
+const uint8_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+void cmdHelp(const CommandArgs& args, CommandReply& reply) { commandHelp(COMMANDS, COMMAND_COUNT, reply); }
+
+void runCommand(const char* line, CommandReply& reply) { commandRun(COMMANDS, COMMAND_COUNT, line, strlen(line), reply); }
+
+void replyBT(void* context, const char* text, size_t length)  { if (btOn) { SerialBT.write((const uint8_t*)text, length); } }
+void replyUSB(void* context, const char* text, size_t length) { Serial.write((const uint8_t*)text, length); }
+CommandReply btReply = { replyBT, nullptr };
+CommandReply usbReply = { replyUSB, nullptr };
+
+struct OscReply {
+  char text[OSC_REPLY_SIZE];
+  size_t length;
+};
+
+// Where a packet came from, read right after parsePacket(): every
+// beginPacket() on Udp, including the one in oscSend(), replaces what
+// remoteIP() and remotePort() return, so they cannot be asked again while
+// the elements of a bundle are handled.
+struct OscSender {
+  IPAddress ip;
+  uint16_t port;
+};
+
+void oscReply(OSCMessage& msg, const OscSender& from) {
+  Udp.beginPacket(from.ip, from.port);
+  msg.send(Udp);
+  Udp.endPacket();
+}
+
+// To the sender's port on every host, for a tool that may not share our subnet.
+void oscBroadcast(OSCMessage& msg, const OscSender& from) {
+  Udp.beginPacket(IPAddress(255, 255, 255, 255), from.port);
+  msg.send(Udp);
+  Udp.endPacket();
+}
+
+void replyOSC(void* context, const char* text, size_t length) {
+  OscReply& out = *(OscReply*)context;
+  length = min(length, sizeof(out.text) - 1 - out.length);  // Cut, not dropped, if it does not fit
+  memcpy(out.text + out.length, text, length);
+  out.length += length;
+  out.text[out.length] = '\0';
+}
+
+// "/command <line>" - any text command over the network. The reply goes back
+// to the sender in one "/command/reply <text>".
+void oscReceiveCommand(const OSCView& view, const OscSender& from) {
+  const char* line;
+  if (!oscViewString(view, 0, line)) { return; }
+  static OscReply out;
+  out.length = 0;
+  out.text[0] = '\0';
+  CommandReply reply = { replyOSC, &out };
+  runCommand(line, reply);
+  OSCMessage msg("/command/reply");
+  msg.add(out.text);
+  oscReply(msg, from);
+}
+
+// "/config/get [name...]" replies "/config/values <id> <name> <value>..." with
+// every field of config.h, or the ones named. "/config/set <name> <value>..."
+// checks the fields together and applies all of them with one NVS write, or
+// none; any /config/set messages in one bundle count as a single change.
+// It replies "/config/ack <id> <ok> <message>". Both replies go to the sender,
+// so a setup tool can broadcast and collect the answers of the whole fleet.
+void oscConfigGet(const OSCView& view, const OscSender& from) {
+  DeviceConfig config = packConfig();
+  OSCMessage msg("/config/values");
+  msg.add((int32_t)device_id);
+  uint8_t names = strlen(view.types);
+  for (uint8_t i = 0; i < (names ? names : CONFIG_FIELD_COUNT); i++) {
+    const ConfigField* field = nullptr;
+    const char* name;
+    if (!names) { field = &CONFIG_FIELDS[i]; }
+    else if (oscViewString(view, i, name)) { field = configField(name, strlen(name)); }
+    if (!field) { continue; }                    // Unknown names are left out
+    msg.add(field->name);
+    if (field->type == CONFIG_FIELD_IP) {
+      const uint8_t* a = configFieldIp(config, *field);
+      msg.add(IPText(IPAddress(a[0], a[1], a[2], a[3])).text);
+    }
+    else if (field->type == CONFIG_FIELD_DMX) { msg.add(dmxProtocolName(configFieldGet(config, *field))); }
+    else { msg.add((int32_t)configFieldGet(config, *field)); }
+  }
+  oscReply(msg, from);
+}
+
+
+// Answers everything a message or bundle changed: /config/ack to the sender,
+// /provision/ack as a broadcast, see fleet.h.
+void oscConfigAck(const DeviceConfig& next, const char* problem, bool configSet, bool provisioned,
+                  const OscSender& from) {
+  if (!problem && !stripsValid(next)) { problem = "strips: pins not free or shared, or too many LEDs"; }
+  const char* result = problem ? problem : changeConfig(next, provisioned);
+  if (configSet) {
+    OSCMessage msg("/config/ack");
+    msg.add((int32_t)device_id);
+    msg.add((int32_t)!problem);
+    msg.add(result);
+    oscReply(msg, from);
+  }
+  if (provisioned) {
+    char mac[FLEET_MAC_TEXT];
+    fleetMacText(ethMac, mac);
+    OSCMessage msg("/provision/ack");
+    msg.add(mac);
+    msg.add((int32_t)!problem);
+    msg.add(result);
+    oscBroadcast(msg, from);
+  }
+  if (DEBUG) { Serial.printf("OSC config change: %s\n", result); }
+}
+
+void oscDiscover(const OscSender& from) {
+  char mac[FLEET_MAC_TEXT];
+  fleetMacText(ethMac, mac);
+  OSCMessage msg("/discover/reply");
+  msg.add(mac);
+  msg.add((int32_t)device_id);
+  msg.add(IPText(ETH.localIP()).text);
+  msg.add(FIRMWARE_VERSION);
+  msg.add((int32_t)millis());
+  oscBroadcast(msg, from);
+}
+
+// "/config/set" or "/provision" on its own; see oscReceiveBundle() for several.
+void oscReceiveConfig(const OSCView& view, bool provision, const OscSender& from) {
+  if (provision && !fleetForMe(view, ethMac)) { return; }
+  DeviceConfig next = packConfig();
+  oscConfigAck(next, fleetApplyFields(view, provision ? 1 : 0, next), !provision, provision, from);
+}
+
+// Every message is parsed once, by the caller, and handed on by address;
+// the pixel and latch messages that arrive at frame rate are checked first.
+void oscReceiveMessage(const OSCView& view, uint32_t arrivedUs, const OscSender& from) {
+  const char* address = view.address;
+  int32_t a = 0, b = 0, c = 0;                     // Missing integer arguments read as 0
+  if (strcmp(address, "/pixels") == 0) { oscReceivePixels(view); }
+  else if (strcmp(address, "/pixels/delta") == 0) { oscReceivePixelOps(view, false); }
+  else if (strcmp(address, "/pixels/key") == 0) { oscReceivePixelOps(view, true); }
+  else if (strcmp(address, "/latch") == 0) { oscReceiveLatch(view, arrivedUs); }
+  else if (strcmp(address, "/time") == 0) { oscReceiveTime(view, arrivedUs); }
+  else if (strcmp(address, "/command") == 0) { oscReceiveCommand(view, from); }
+  else if (strcmp(address, "/config/get") == 0) { oscConfigGet(view, from); }
+  else if (strcmp(address, "/config/set") == 0) { oscReceiveConfig(view, false, from); }
+  else if (strcmp(address, "/provision") == 0) { oscReceiveConfig(view, true, from); }
+  else if (strcmp(address, "/discover") == 0) { oscDiscover(from); }
+  else if (strcmp(address, "/device/") == 0) {
+    oscViewInt(view, 0, a);
+    processOSCData(a);
+    if (DEBUG) {Serial.printf("Received OSC message: Address = /device/, Value = %d\n", a);}
+  } else if (strcmp(address, "/clear/") == 0) {
+    stageFrame();
+    effectsStop();
+    effectsSetBase(FRAME_IDLE); // Back to the idle colour
+    if (DEBUG) {Serial.println("Received OSC message: /clear/ - NeoPixel strip1 cleared.");}
+  } else if (strcmp(address, "/pixel") == 0) {     // "/pixel <index> <0xRRGGBB>", logical index across all strips
+    oscViewInt(view, 0, a);
+    oscViewInt(view, 1, b);
+    stageFrame();
+    effectsDirect();
+    effectsLockCanvas();
+    canvas.setPixel(a, b);
+    effectsUnlockCanvas();
+    frameDone();
+  } else if (strcmp(address, "/fill") == 0) {      // "/fill <first> <count> <0xRRGGBB>"
+    oscViewInt(view, 0, a);
+    oscViewInt(view, 1, b);
+    oscViewInt(view, 2, c);
+    stageFrame();
+    effectsDirect();
+    effectsLockCanvas();
+    canvas.fill(c, a, b);
+    effectsUnlockCanvas();
+    frameDone();
+  } else if (strncmp(address, "/effect/", 8) == 0) { // "/effect/<name> [duration_ms] [0xRRGGBB]"
+    EffectType type = effectFromName(address + 8);
+    oscViewInt(view, 0, a);
+    oscViewInt(view, 1, b);                         // 0 = current base colour
+    if (type != EFFECT_COUNT) { stageFrame(); effectsPlay(type, b, 255, a); }
+    if (DEBUG) {Serial.printf("Received OSC message: %s, Duration = %u\n", address, (uint32_t)a);}
+  } else if (strncmp(address, "/anim/", 6) == 0) { // "/anim/<name> [loop]"
+    AnimClip clip;
+    bool loop = oscViewInt(view, 0, a) && a;
+    if (animOpen(address + 6, canvas, clip)) { stageFrame(); effectsPlayClip(clip, loop); }
+    if (DEBUG) {Serial.printf("Received OSC message: %s, Loop = %d\n", address, loop);}
+  } else { Serial.println("Received OSC message with unmatched address."); }
+}
+
+// Bundle elements are handled in order, except that all /config/set in it,
+// and the /provision for this slave, are gathered into one change.
+void oscReceiveBundle(const uint8_t* packet, int packetSize, uint32_t arrivedUs, const OscSender& from) {
+  DeviceConfig next = packConfig();
+  const char* problem = nullptr;
+  bool configSet = false, provisioned = false;
+  const uint8_t* element;
+  int elementSize, offset = 0;
+  while (oscBundleNext(packet, packetSize, offset, element, elementSize)) {
+    OSCView view;
+    bool parsed = oscViewParse(element, elementSize, view);
+    if (parsed && strcmp(view.address, "/config/set") == 0) {
+      if (!problem) { problem = fleetApplyFields(view, 0, next); }
+      configSet = true;
+    }
+    else if (parsed && strcmp(view.address, "/provision") == 0) {
+      if (!fleetForMe(view, ethMac)) { continue; }  // Another slave's
+      if (!problem) { problem = fleetApplyFields(view, 1, next); }
+      provisioned = true;
+    }
+    else if (parsed) { oscReceiveMessage(view, arrivedUs, from); }
+  }
+  if (configSet || provisioned) { oscConfigAck(next, problem, configSet, provisioned, from); }
+}
+
+void oscReceive() {
+  static uint8_t packet[OSC_PACKET_SIZE];
+  int packetSize = Udp.parsePacket(); // Check if a packet is available
+  if (packetSize > 0) {
+    uint32_t arrivedUs = micros();
+    OscSender from = { Udp.remoteIP(), Udp.remotePort() };
+    if (!firstPacketUs) { firstPacketUs = arrivedUs; }
+    packetSize = Udp.read(packet, min(packetSize, OSC_PACKET_SIZE)); // One bulk read instead of a call per byte
+    if (packetSize <= 0) { return; }
+    OSCView view;
+    if (packet[0] == '#') { oscReceiveBundle(packet, packetSize, arrivedUs, from); }
+    else if (oscViewParse(packet, packetSize, view)) { oscReceiveMessage(view, arrivedUs, from); }
+    else if (DEBUG) { Serial.println("Received a malformed OSC packet."); }
+  }
 }
 
-void readBTSerial(){
-  if (SerialBT.available()) {
-    String incoming = SerialBT.readStringUntil('\n');
-    processData(incoming);
-    if (DEBUG) {SerialBT.println(incoming);}
+// Takes only the bytes already received, so a line still on its way never
+// holds up the switch, OSC or DMX; it completes on a later pass.
+void readCommands(Stream& stream, LineReader& reader, CommandReply& reply) {
+  int available = stream.available();
+  while (available-- > 0) {
+    const char* line = lineReaderPut(reader, stream.read());
+    if (!line) { continue; }
+    runCommand(line, reply);
+    if (DEBUG && line[0]) { stream.println(line); }
   }
 }
 
+void readBTSerial() { if (btOn) { readCommands(SerialBT, btLine, btReply); } }
+
+// Bringing up the Bluetooth stack takes a large part of a second, so it
+// runs on its own task next to the network and leaves loop() free.
+void btTask(void* parameter) {
+  btOn = SerialBT.begin(DEVICE_NAME + String(device_id));
+  bootEnd(BOOT_BLUETOOTH);
+  vTaskDelete(NULL);
+}
+
+// Bluetooth is on from boot for btWindow seconds, or for good with no window
+// or while the switch was held at power-up. A connected client keeps it on
+// until it disconnects. Closing releases the controller's and Bluedroid's
+// memory to the heap, so it only comes back with a restart.
+void btBegin() {
+  bootStart(BOOT_BLUETOOTH);
+  btHeld = digitalRead(SWITCH_PIN) == LOW;
+  if (xTaskCreatePinnedToCore(btTask, "btBegin", 8192, NULL, 1, NULL, 0) != pdPASS) { bootEnd(BOOT_BLUETOOTH); }
+}
+
+void btClose() {
+  if (!btOn || btHeld || !btWindow || millis() < btWindow * 1000UL || SerialBT.hasClient()) { return; }
+  int32_t heap = ESP.getFreeHeap();
+  SerialBT.end();                                // Stops Bluedroid and the controller
+  esp_err_t released = esp_bt_mem_release(ESP_BT_MODE_BTDM); // Controller and host memory both
+  btOn = false;
+  btOffMillis = millis();
+  btFreed = (int32_t)ESP.getFreeHeap() - heap;   // Measured, not assumed
+  if (released != ESP_OK) { Serial.printf("Bluetooth memory not released: %s\n", esp_err_to_name(released)); }
+  if (DEBUG) { Serial.printf("Bluetooth off, heap %+d bytes\n", btFreed); }
+}
+
+void reportBoot() {
+  if (bootReported || !bootReadyUs()) { return; }
+  bootReported = true;
+  if (DEBUG) { getBoot(usbReply); }
+}
+
+void countLoop() {
+  loopPasses++;
+  uint32_t elapsed = millis() - loopMillis;
+  if (elapsed < 1000) { return; }
+  loopRate = loopPasses * 1000ULL / elapsed;
+  if (btOn) { loopRateBt = loopRate; }
+  loopPasses = 0;
+  loopMillis = millis();
+}
+void readUSBSerial() { readCommands(Serial, usbLine, usbReply); }
+
+// A press before Ethernet has its address is held and sent once it has,
+// rather than lost. Presses held together are one press to the master.
+void sendPress() {
+  if (ethReady) { oscSend(device_id); return; }
+  pressQueued = true;
+  pressesQueued++;
+}
+
+void sendQueuedPress() {
+  if (!pressQueued || !ethReady) { return; }
+  pressQueued = false;
+  oscSend(device_id);
+}
+
 void readSwitch(){
+  static bool released = false;     // A switch held at power-up is not a press
+  if (!released) { released = digitalRead(SWITCH_PIN) == HIGH; return; }
   if (millis() - lastMillis < DEBOUNCE_DELAY){ return; } // Debounce delay
   if (digitalRead(SWITCH_PIN) == LOW) { // Check if switch is pressed
     if (DEBUG) { Serial.println("Switch pressed"); }
-    oscSend(device_id); 
+    sendPress();
+    dropPixelBase();
+    effectsPlay(EFFECT_PULSE, 0, 255, 0); // Local feedback, does not wait for the master
     lastMillis = millis();
   }
 }
@@ -231,16 +1015,21 @@ void WiFiEvent(WiFiEvent_t event) {
       ETH.setHostname("esp32-ethernet");
       break;
     case SYSTEM_EVENT_ETH_CONNECTED:
+      if (!linkUpUs) { linkUpUs = micros(); }
       Serial.println("ETH Connected");
       break;
     case SYSTEM_EVENT_ETH_GOT_IP:
-      Serial.print("ETH IP: ");
-      Serial.println(ETH.localIP());
+      bootEnd(BOOT_LINK);
+      ethReady = true;
+      if (addressSource == ADDRESS_DHCP) { leaseChanged = true; } // Also on a renewal to a new address
+      Serial.printf("ETH IP: %s (%s)\n", IPText(ETH.localIP()).text, ADDRESS_SOURCE_NAMES[addressSource]);
       break;
     case SYSTEM_EVENT_ETH_DISCONNECTED:
+      ethReady = false;
       Serial.println("ETH Disconnected");
       Serial.println("ERROR: No Ethernet connection - Restarting ESP32... ");
-      ESP.restart(); // Restart ESP32 if disconnected
+      restartMillis = millis();
+      restartPending = true; // Restart ESP32 if disconnected, from loop() once settings are written
       break;
     case SYSTEM_EVENT_ETH_STOP:
       Serial.println("ETH Stopped");
@@ -250,45 +1039,137 @@ void WiFiEvent(WiFiEvent_t event) {
   }
 }
 
+// With DHCP, a warm restart with a cached lease takes it at once, so the
+// podium is ready at link-up as with a static address, and dhcpRenew() then
+// asks the server in the background. Otherwise the server is asked straight
+// away and dhcpFallback() sets an address if it gets no answer.
+void ethAddress() {
+  if (!dhcp) {
+    addressSource = ADDRESS_STATIC;
+    ETH.config(ip, gateway, subnet);
+  } else if (warmRestart() && (uint32_t)leaseIp) {
+    addressSource = ADDRESS_LEASE;
+    ETH.config(leaseIp, leaseGateway, leaseSubnet);
+  } else {
+    addressSource = ADDRESS_DHCP;
+    ETH.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+  }
+}
+
+// After a power-on, or with no lease yet, a server that does not answer
+// leaves the podium on the static address.
+void dhcpFallback() {
+  if (addressSource != ADDRESS_DHCP || ethReady || !linkUpUs || micros() - linkUpUs < DHCP_TIMEOUT_MS * 1000UL) { return; }
+  addressSource = ADDRESS_FALLBACK;
+  if (DEBUG) { Serial.println("No DHCP answer, using the static address"); }
+  if (ETH.config(ip, gateway, subnet)) {
+    bootEnd(BOOT_LINK);
+    ethReady = true;
+  }
+}
+
+static void dhcpStart(void* netif) { dhcp_start((struct netif*)netif); } // On the lwIP thread
+
+// The lease may have run out while the podium was down, so the server is
+// still asked once the link is up. DHCP is started on the lwIP interface
+// itself: ETH.config() would clear the address first, this keeps the lease
+// in use until the server answers and lwIP moves to the address it grants,
+// then renews it as usual. Nothing changes if the server never answers.
+void dhcpRenew() {
+  if (!ethReady || (addressSource != ADDRESS_LEASE && !leaseRenewing)) { return; }
+  struct netif* netif = nullptr;
+  if (tcpip_adapter_get_netif(TCPIP_ADAPTER_IF_ETH, (void**)&netif) != ESP_OK || !netif) { return; }
+  if (!leaseRenewing) {
+    leaseRenewing = tcpip_callback(dhcpStart, netif) == ERR_OK;
+    return;
+  }
+  if (!dhcp_supplied_address(netif)) { return; }
+  if (addressSource == ADDRESS_LEASE) {
+    addressSource = ADDRESS_DHCP;
+    leaseChanged = true;
+    Serial.printf("ETH IP: %s (%s)\n", IPText(ETH.localIP()).text, ADDRESS_SOURCE_NAMES[addressSource]);
+  }
+  if (ip4_addr_get_u32(netif_ip4_addr(netif)) != (uint32_t)leaseIp) { leaseChanged = true; } // Moved at a renewal
+}
+
+// The lease is what a warm restart starts from; the write is skipped if it
+// matches the one stored.
+void cacheLease() {
+  if (!leaseChanged) { return; }
+  leaseChanged = false;
+  leaseIp = ETH.localIP();
+  leaseSubnet = ETH.subnetMask();
+  leaseGateway = ETH.gatewayIP();
+  saveConfig();
+}
+
+// Nothing here waits for the link. The address is set as soon as begin()
+// has created the interface, the sockets are bound to it at once and take
+// packets from the moment it comes up; WiFiEvent() reports the link and
+// the address, and presses wait for ethReady.
 void ethInit() {
+  WiFi.onEvent(WiFiEvent);     // Before begin(), so the link is timed from the start
+  bootStart(BOOT_LINK);
   ETH.begin( ETH_ADDR, ETH_POWER_PIN, ETH_MDC_PIN, ETH_MDIO_PIN, ETH_TYPE, ETH_CLK_MODE_0);
-  ETH.config(ip, gateway, subnet);
-  WiFi.onEvent(WiFiEvent);
+  ethAddress();
   Udp.begin(inPort);
-  delay(10); // Wait for the Ethernet to initialize
+  dmxBegin();
   Serial.println("ETH Initialized");
-  Serial.printf("ETH IP: %s\n", ETH.localIP().toString().c_str());
-  Serial.printf("ETH MAC: %s\n", ETH.macAddress().c_str());
+  ETH.macAddress(ethMac);
+  char mac[FLEET_MAC_TEXT];
+  fleetMacText(ethMac, mac);
+  Serial.printf("ETH MAC: %s\n", mac);
 }
 
 void stripInit() {
-  for (auto& strip : {&strip1, &strip2, &strip3}) {
-    strip->begin();                  // Initialize the NeoPixel strip
-    strip->setBrightness(128);       // Set brightness to 50 (0-255)
-    strip->fill(strip->Color(WHITE)); // Fill the strip with white color
-    strip->show();                   // Update the strip to show the new color
-  }
-  delay(1000);                       // Wait for 1 second
-
-  for (auto& strip : {&strip1, &strip2, &strip3}) {
-    if (device_id <= 4){strip->fill(strip->Color(BLUE)); } // Fill the strip with blue color
-    else if (device_id > 4) {strip->fill(strip->Color(MAGENTA));}
-    strip->show();                   // Update the strip to show the new color
+  for (auto& segment : layout) {
+    if (!segment.count) { continue; }
+    if (segment.clock >= 0) { canvas.addClockedSegment(segment.pin, segment.clock, segment.count); }
+    else { canvas.addSegment(segment.pin, segment.count); }
   }
+  if (!canvas.begin()) { Serial.println("ERROR: No memory for the LED framebuffer or SPI bus"); }
+  effectsBegin(canvas);                          // Frames are rendered on their own task from here on
+  effectsDefineFrame(FRAME_BOOT, Adafruit_NeoPixel::Color(WHITE), 128);
+  effectsDefineFrame(FRAME_IDLE, idleColor(), 128);
+  effectsDefineFrame(FRAME_HIT,  Adafruit_NeoPixel::Color(RED), 255);
+  effectsSetBase(FRAME_IDLE);                    // Idle colour at half brightness
+  bool clips = animBegin();                      // Mapped on every boot: /anim/ plays from it after a warm restart too
+  AnimClip intro;
+  if (warmRestart()) { return; }                 // Restarted mid-show: straight back to idle
+  if (clips && animOpen("intro", canvas, intro)) { effectsPlayClip(intro, false); } // Intro from flash if one was uploaded
+  else { effectsShowFrame(FRAME_BOOT, 1000); }   // White for 1 second at boot, without blocking
 }
 
 void setup() {
   Serial.begin(115200);
   pinMode(SWITCH_PIN, INPUT_PULLUP); // Set switch pin as input with pull-up resistor
-  loadConfig(); // Load device ID from Preferences
-  SerialBT.begin(DEVICE_NAME + String(device_id)); // Initialize Bluetooth Serial
-  stripInit();
-  loadNetworkConfig(); // Load network configuration from Preferences
-  ethInit(); // Initialize Ethernet
+  bootStart(BOOT_CONFIG);
+  loadConfig(); // All settings from the stored record
+  bootEnd(BOOT_CONFIG);
+  bootStart(BOOT_ETHERNET);
+  ethInit(); // Initialize Ethernet, the link comes up in the background
+  bootEnd(BOOT_ETHERNET);
+  bootStart(BOOT_LEDS);
+  stripInit(); // Boot animation plays on the effects task
+  applyConfig(); // Dithering and power budget for the strips
+  bootEnd(BOOT_LEDS);
+  btBegin(); // Bluetooth Serial on its own task, for the window set with SET_BT_WINDOW
+  setupDoneUs = micros();
 }
 
 void loop() {
   readSwitch();   // Read switch state and send OSC message if pressed
+  dhcpFallback();  // Static address if DHCP does not answer
+  dhcpRenew();     // DHCP behind the cached lease after a warm restart
+  cacheLease();    // New DHCP lease, for the next warm restart
+  sendQueuedPress(); // A press from before the link came up
   readBTSerial(); // Read data from Bluetooth Serial
+  btClose();      // Bluetooth off once its window is over
+  readUSBSerial(); // Same commands from the USB serial port
   oscReceive();   // Check for incoming OSC messages
+  dmxReceive();   // Check for incoming Art-Net / sACN data
+  flushConfigWhenQuiet(); // Changed settings, once the changes stop
+  restartWhenDue(); // New strip layout or network, lost link
+  countLoop();    // Loop rate for STATS
+  reportBoot();   // Time to ready, once
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "osc_view.h"
+#include <string.h>
+
+static inline uint32_t pad4(uint32_t n) { return (n + 3) & ~3u; }
+
+static inline uint32_t readBE32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Length of a padded OSC string starting at p, 0 if it is not terminated before end
+static uint32_t paddedString(const uint8_t* p, const uint8_t* end) {
+  const uint8_t* nul = (const uint8_t*)memchr(p, 0, end - p);
+  return nul ? pad4(nul - p + 1) : 0;
+}
+
+bool oscViewParse(const uint8_t* packet, int size, OSCView& view) {
+  if (size < 8 || (size & 3) || packet[0] != '/') { return false; } // Bundles start with '#'
+  const uint8_t* end = packet + size;
+  uint32_t addressLen = paddedString(packet, end);
+  if (addressLen == 0 || addressLen >= (uint32_t)size || packet[addressLen] != ',') { return false; }
+  uint32_t typesLen = paddedString(packet + addressLen, end);
+  if (typesLen == 0) { return false; }
+  view.address = (const char*)packet;
+  view.types = (const char*)packet + addressLen + 1;
+  view.args = packet + addressLen + typesLen;
+  view.end = end;
+  return view.args <= end;
+}
+
+// Finds argument `index` and checks it fits in the packet
+static const uint8_t* findArg(const OSCView& view, uint8_t index, char& type) {
+  const uint8_t* p = view.args;
+  for (uint8_t i = 0; view.types[i]; i++) {
+    type = view.types[i];
+    uint32_t len;
+    switch (type) {
+      case 'i': case 'f': len = 4; break;
+      case 's': len = paddedString(p, view.end); if (len == 0) { return nullptr; } break;
+      case 'b':
+        if (view.end - p < 4 || readBE32(p) > (uint32_t)(view.end - p) - 4) { return nullptr; }
+        len = 4 + pad4(readBE32(p));
+        break;
+      default: return nullptr;   // Unsupported type, offsets after it are unknown
+    }
+    if ((uint32_t)(view.end - p) < len) { return nullptr; }
+    if (i == index) { return p; }
+    p += len;
+  }
+  return nullptr;
+}
+
+bool oscViewInt(const OSCView& view, uint8_t index, int32_t& value) {
+  char type;
+  const uint8_t* p = findArg(view, index, type);
+  if (!p || type != 'i') { return false; }
+  value = (int32_t)readBE32(p);
+  return true;
+}
+
+bool oscViewBlob(const OSCView& view, uint8_t index, const uint8_t*& data, uint32_t& size) {
+  char type;
+  const uint8_t* p = findArg(view, index, type);
+  if (!p || type != 'b') { return false; }
+  size = readBE32(p);
+  data = p + 4;
+  return true;
+}
+
+bool oscViewString(const OSCView& view, uint8_t index, const char*& text) {
+  char type;
+  const uint8_t* p = findArg(view, index, type);
+  if (!p || type != 's') { return false; }
+  text = (const char*)p;                        // findArg checked the terminator
+  return true;
+}
+
+bool oscBundleNext(const uint8_t* packet, int size, int& offset, const uint8_t*& element, int& elementSize) {
+  if (offset == 0) {
+    if (size < 16 || memcmp(packet, "#bundle", 8) != 0) { return false; }
+    offset = 16;                                  // Header and time tag
+  }
+  if (offset + 4 > size) { return false; }
+  uint32_t length = readBE32(packet + offset);
+  if (length > (uint32_t)(size - offset - 4)) { return false; }
+  element = packet + offset + 4;
+  elementSize = length;
+  offset += 4 + length;
+  return true;
+}
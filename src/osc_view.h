@@ -0,0 +1,26 @@
+#ifndef OSC_VIEW_H
+#define OSC_VIEW_H
+
+#include <stdint.h>
+
+// Read-only view of one OSC message inside a received packet. Nothing is
+// copied or allocated: strings and blobs point into the packet, which must
+// stay alive while the view is used. Only the i, f, s and b argument types
+// are understood, which covers what the master sends.
+struct OSCView {
+  const char* address;
+  const char* types;      // Type tags without the leading ','
+  const uint8_t* args;    // First argument
+  const uint8_t* end;     // One past the last byte of the packet
+};
+
+bool oscViewParse(const uint8_t* packet, int size, OSCView& view);
+bool oscViewInt(const OSCView& view, uint8_t index, int32_t& value);
+bool oscViewBlob(const OSCView& view, uint8_t index, const uint8_t*& data, uint32_t& size);
+bool oscViewString(const OSCView& view, uint8_t index, const char*& text); // NUL-terminated, in the packet
+
+// Steps through the elements of a "#bundle" packet; `offset` starts at 0.
+// The time tag is not read, elements are handled as they arrive.
+bool oscBundleNext(const uint8_t* packet, int size, int& offset, const uint8_t*& element, int& elementSize);
+
+#endif
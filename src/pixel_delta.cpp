@@ -0,0 +1,131 @@
+#include "pixel_delta.h"
+#include <string.h>
+
+static inline bool samePixel(const uint8_t* a, const uint8_t* b) { return a[0] == b[0] && a[1] == b[1] && a[2] == b[2]; }
+
+static inline bool smallDelta(const uint8_t* prev, const uint8_t* next) {
+  for (uint8_t c = 0; c < 3; c++) {
+    int d = next[c] - prev[c];
+    if (d < -128 || d > 127) { return false; }
+  }
+  return true;
+}
+
+uint32_t pixelDeltaEncode(const uint8_t* prev, const uint8_t* next, uint16_t numPixels,
+                          uint8_t* out, uint32_t capacity) {
+  uint32_t used = 0;
+  uint16_t i = 0;
+  // Trailing unchanged pixels need no op at all
+  while (numPixels > 0 && samePixel(prev + (numPixels - 1) * 3, next + (numPixels - 1) * 3)) { numPixels--; }
+  while (i < numPixels) {
+    const uint8_t* p = prev + i * 3;
+    const uint8_t* n = next + i * 3;
+    uint16_t count = 1;
+    uint8_t op;
+    if (samePixel(p, n)) {
+      op = PIXEL_OP_SKIP;
+      while (i + count < numPixels && count < PIXEL_OP_MAX_RUN && samePixel(p + count * 3, n + count * 3)) { count++; }
+    } else if (i + 1 < numPixels && samePixel(n, n + 3)) {
+      op = PIXEL_OP_RUN;
+      while (i + count < numPixels && count < PIXEL_OP_MAX_RUN && samePixel(n, n + count * 3)) { count++; }
+    } else {
+      op = smallDelta(p, n) ? PIXEL_OP_DELTA : PIXEL_OP_LITERAL;
+      // Extend while the next pixel changes, is not the start of a run and suits the same op
+      while (i + count < numPixels && count < PIXEL_OP_MAX_RUN) {
+        const uint8_t* pc = p + count * 3;
+        const uint8_t* nc = n + count * 3;
+        if (samePixel(pc, nc) || (i + count + 1 < numPixels && samePixel(nc, nc + 3))) { break; }
+        if ((op == PIXEL_OP_DELTA) != smallDelta(pc, nc)) { break; }
+        count++;
+      }
+    }
+    uint32_t payload = (op == PIXEL_OP_SKIP) ? 0 : (op == PIXEL_OP_RUN) ? 3 : count * 3;
+    if (used + 1 + payload > capacity) { return 0; }
+    out[used++] = op | (count - 1);
+    if (op == PIXEL_OP_RUN || op == PIXEL_OP_LITERAL) { memcpy(out + used, n, payload); }
+    else if (op == PIXEL_OP_DELTA) {
+      for (uint32_t b = 0; b < payload; b++) { out[used + b] = (uint8_t)(n[b] - p[b]); }
+    }
+    used += payload;
+    i += count;
+  }
+  return used;
+}
+
+bool pixelDeltaValid(const uint8_t* ops, uint32_t size, uint16_t numPixels) {
+  uint32_t pos = 0, pixel = 0;
+  while (pos < size) {
+    uint8_t op = ops[pos] & 0xC0;
+    uint16_t count = (ops[pos] & 0x3F) + 1;
+    uint32_t payload = (op == PIXEL_OP_SKIP) ? 0 : (op == PIXEL_OP_RUN) ? 3 : count * 3;
+    pos += 1 + payload;
+    pixel += count;
+    if (pos > size || pixel > numPixels) { return false; }
+  }
+  return true;
+}
+
+bool pixelDeltaApplyBuffer(uint8_t* rgb, uint16_t numPixels, const uint8_t* ops, uint32_t size) {
+  if (!pixelDeltaValid(ops, size, numPixels)) { return false; }
+  uint32_t pos = 0;
+  uint8_t* p = rgb;
+  while (pos < size) {
+    uint8_t op = ops[pos] & 0xC0;
+    uint16_t count = (ops[pos++] & 0x3F) + 1;
+    const uint8_t* data = ops + pos;
+    switch (op) {
+      case PIXEL_OP_RUN:
+        for (uint16_t i = 0; i < count; i++) { memcpy(p + i * 3, data, 3); }
+        pos += 3;
+        break;
+      case PIXEL_OP_LITERAL:
+        memcpy(p, data, count * 3);
+        pos += count * 3;
+        break;
+      case PIXEL_OP_DELTA:
+        for (uint16_t b = 0; b < count * 3; b++) { p[b] += data[b]; }
+        pos += count * 3;
+        break;
+      default:
+        break;  // SKIP
+    }
+    p += count * 3;
+  }
+  return true;
+}
+
+#ifdef ARDUINO
+bool pixelDeltaApply(Canvas& canvas, const uint8_t* ops, uint32_t size) {
+  if (!pixelDeltaValid(ops, size, canvas.numPixels())) { return false; }
+  uint32_t pos = 0;
+  uint16_t pixel = 0;
+  while (pos < size) {
+    uint8_t op = ops[pos] & 0xC0;
+    uint16_t count = (ops[pos++] & 0x3F) + 1;
+    const uint8_t* data = ops + pos;
+    switch (op) {
+      case PIXEL_OP_RUN:
+        canvas.fill(Adafruit_NeoPixel::Color(data[0], data[1], data[2]), pixel, count); // One fast fill per run
+        pos += 3;
+        break;
+      case PIXEL_OP_LITERAL:
+        canvas.write(pixel, data, count);
+        pos += count * 3;
+        break;
+      case PIXEL_OP_DELTA:
+        for (uint16_t i = 0; i < count; i++, data += 3) {
+          uint32_t c = canvas.getPixel(pixel + i);
+          canvas.setPixel(pixel + i, Adafruit_NeoPixel::Color((uint8_t)((c >> 16) + data[0]),
+                                                               (uint8_t)((c >> 8) + data[1]),
+                                                               (uint8_t)(c + data[2])));
+        }
+        pos += count * 3;
+        break;
+      default:
+        break;  // SKIP
+    }
+    pixel += count;
+  }
+  return true;
+}
+#endif
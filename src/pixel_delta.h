@@ -0,0 +1,40 @@
+#ifndef PIXEL_DELTA_H
+#define PIXEL_DELTA_H
+
+#include <stdint.h>
+
+// Compact pixel update format for /pixels/delta and /pixels/key. A stream of
+// ops, each one byte: the top two bits select the op, the low six bits hold
+// the pixel count minus one (1-64 pixels per op).
+//   SKIP     n pixels unchanged                      (no payload)
+//   RUN      n pixels of one colour                  (R,G,B)
+//   LITERAL  n pixels of raw colour                  (n x R,G,B)
+//   DELTA    n pixels changed by a signed amount     (n x dR,dG,dB)
+// Ops run from pixel 0 upwards; pixels after the last op are unchanged.
+#define PIXEL_OP_SKIP     0x00
+#define PIXEL_OP_RUN      0x40
+#define PIXEL_OP_LITERAL  0x80
+#define PIXEL_OP_DELTA    0xC0
+#define PIXEL_OP_MAX_RUN  64
+
+// Encodes the change from `prev` to `next` (R,G,B triplets). Returns the
+// number of bytes written to `out`, or 0 if `capacity` is too small. Used by
+// the master and by host tests; the slave only decodes.
+uint32_t pixelDeltaEncode(const uint8_t* prev, const uint8_t* next, uint16_t numPixels,
+                          uint8_t* out, uint32_t capacity);
+
+// Checks that every op fits in `size` bytes and within `numPixels`, so a
+// truncated or corrupt message is rejected before anything is written.
+bool pixelDeltaValid(const uint8_t* ops, uint32_t size, uint16_t numPixels);
+
+// Applies validated ops to a plain R,G,B buffer. Used by host tools that
+// play back recorded streams and animations.
+bool pixelDeltaApplyBuffer(uint8_t* rgb, uint16_t numPixels, const uint8_t* ops, uint32_t size);
+
+#ifdef ARDUINO
+#include "canvas.h"
+// Applies validated ops directly to the canvas framebuffer.
+bool pixelDeltaApply(Canvas& canvas, const uint8_t* ops, uint32_t size);
+#endif
+
+#endif
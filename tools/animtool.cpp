@@ -0,0 +1,162 @@
+// Host tool for the flash animation container (src/anim.h).
+//
+//   g++ -std=c++17 -O2 -Isrc tools/animtool.cpp src/anim.cpp src/pixel_delta.cpp -o animtool
+//
+//   animtool build <anim.bin> <name>:<fps>:<strips>:<frames.rgb> ...
+//       <strips> is the pixel count per strip, e.g. 30,30,30. <frames.rgb>
+//       holds raw R,G,B frames back to back, e.g. from
+//       ffmpeg -i clip.mp4 -vf scale=90:1 -f rawvideo -pix_fmt rgb24 clip.rgb
+//   animtool info <anim.bin>
+//   animtool play <anim.bin> <name> <out.rgb>
+//       Decodes every frame the way the slave does and writes raw frames,
+//       so `cmp frames.rgb out.rgb` checks a build.
+//
+// Upload to the "anim" partition (see partitions.csv) with
+//   esptool.py write_flash 0x400000 anim.bin
+#include "anim.h"
+#include "pixel_delta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+  FILE* f = fopen(path, "rb");
+  if (!f) { return false; }
+  uint8_t chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) { data.insert(data.end(), chunk, chunk + n); }
+  fclose(f);
+  return true;
+}
+
+static bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+  FILE* f = fopen(path, "wb");
+  if (!f) { return false; }
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  return fclose(f) == 0 && ok;
+}
+
+template <typename T> static void append(std::vector<uint8_t>& out, const T& value) {
+  const uint8_t* p = (const uint8_t*)&value;
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+static int build(const char* outPath, int count, char** specs) {
+  std::vector<uint8_t> out(sizeof(AnimFileHeader) + count * sizeof(AnimClipEntry));
+  std::vector<AnimClipEntry> entries(count);
+  for (int c = 0; c < count; c++) {
+    // name:fps:strips:file
+    std::string spec = specs[c];
+    size_t a = spec.find(':'), b = spec.find(':', a + 1), d = spec.find(':', b + 1);
+    if (a == std::string::npos || b == std::string::npos || d == std::string::npos) {
+      fprintf(stderr, "bad clip spec '%s'\n", specs[c]);
+      return 1;
+    }
+    std::string name = spec.substr(0, a), strips = spec.substr(b + 1, d - b - 1), path = spec.substr(d + 1);
+    int fps = atoi(spec.substr(a + 1, b - a - 1).c_str());
+    AnimClipHeader header = {};
+    uint32_t numPixels = 0;
+    for (const char* s = strips.c_str(); *s; ) {
+      char* end;
+      long n = strtol(s, &end, 10);
+      if (end == s || n <= 0 || header.segmentCount >= ANIM_MAX_SEGMENTS) { fprintf(stderr, "bad strips '%s'\n", strips.c_str()); return 1; }
+      header.segments[header.segmentCount++] = n;
+      numPixels += n;
+      s = (*end == ',') ? end + 1 : end;
+    }
+    std::vector<uint8_t> frames;
+    if (name.empty() || name.size() >= ANIM_NAME_LEN || fps < 1 || fps > 255 || numPixels > 65535) {
+      fprintf(stderr, "bad clip '%s': name up to %d chars, fps 1-255\n", specs[c], ANIM_NAME_LEN - 1);
+      return 1;
+    }
+    if (!readFile(path.c_str(), frames) || frames.size() % (numPixels * 3) || frames.size() / (numPixels * 3) > 65535) {
+      fprintf(stderr, "%s: not a whole number of %u-pixel frames\n", path.c_str(), numPixels);
+      return 1;
+    }
+    header.frameCount = frames.size() / (numPixels * 3);
+    header.numPixels = numPixels;
+    header.fps = fps;
+
+    while (out.size() & 3) { out.push_back(0); }
+    uint32_t base = out.size();
+    append(out, header);
+    uint32_t indexPos = out.size();
+    out.resize(out.size() + (header.frameCount + 1) * sizeof(uint32_t));
+    std::vector<uint8_t> prev(numPixels * 3, 0), ops(numPixels * 4 + 64);
+    uint32_t raw = 0;
+    for (uint32_t f = 0; f <= header.frameCount; f++) {
+      uint32_t offset = out.size() - base;
+      memcpy(&out[indexPos + f * sizeof(uint32_t)], &offset, sizeof(offset));
+      if (f == header.frameCount) { break; }
+      const uint8_t* next = &frames[f * numPixels * 3];
+      uint32_t size = pixelDeltaEncode(prev.data(), next, numPixels, ops.data(), ops.size());
+      out.insert(out.end(), ops.begin(), ops.begin() + size);
+      memcpy(prev.data(), next, numPixels * 3);
+      raw += numPixels * 3;
+    }
+    AnimClipEntry& entry = entries[c];
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.name, name.data(), name.size());
+    entry.offset = base;
+    entry.size = out.size() - base;
+    printf("%-15s %5u frames at %3d fps, %4u pixels, %u -> %u bytes\n",
+           name.c_str(), header.frameCount, fps, numPixels, raw, entry.size);
+  }
+  AnimFileHeader file = { ANIM_MAGIC, ANIM_VERSION, (uint16_t)count, (uint32_t)out.size() };
+  memcpy(&out[0], &file, sizeof(file));
+  memcpy(&out[sizeof(file)], entries.data(), count * sizeof(AnimClipEntry));
+  if (!animValid(out.data(), out.size())) { fprintf(stderr, "internal error: container does not validate\n"); return 1; }
+  if (!writeFile(outPath, out)) { fprintf(stderr, "cannot write %s\n", outPath); return 1; }
+  printf("%s: %u bytes\n", outPath, (uint32_t)out.size());
+  return 0;
+}
+
+static bool load(const char* path, std::vector<uint8_t>& data) {
+  if (!readFile(path, data)) { fprintf(stderr, "cannot read %s\n", path); return false; }
+  if (!animValid(data.data(), data.size())) { fprintf(stderr, "%s: not a valid animation container\n", path); return false; }
+  return true;
+}
+
+static int info(const char* path) {
+  std::vector<uint8_t> data;
+  if (!load(path, data)) { return 1; }
+  for (uint16_t c = 0; c < animClipCount(data.data()); c++) {
+    AnimClip clip;
+    char name[ANIM_NAME_LEN + 1] = {};
+    memcpy(name, animClipName(data.data(), c), ANIM_NAME_LEN);
+    animFind(data.data(), name, clip);
+    printf("%-15s %5u frames at %3u fps, %4u pixels in %u strips\n", name, clip.header->frameCount,
+           clip.header->fps, clip.header->numPixels, clip.header->segmentCount);
+  }
+  return 0;
+}
+
+static int play(const char* path, const char* name, const char* outPath) {
+  std::vector<uint8_t> data;
+  AnimClip clip;
+  if (!load(path, data)) { return 1; }
+  if (!animFind(data.data(), name, clip)) { fprintf(stderr, "no clip '%s'\n", name); return 1; }
+  uint16_t numPixels = clip.header->numPixels;
+  std::vector<uint8_t> rgb(numPixels * 3, 0), out;
+  for (uint16_t f = 0; f < clip.header->frameCount; f++) {
+    const uint8_t* ops;
+    uint32_t size;
+    animFrame(clip, f, ops, size);
+    if (!pixelDeltaApplyBuffer(rgb.data(), numPixels, ops, size)) { fprintf(stderr, "frame %u is corrupt\n", f); return 1; }
+    out.insert(out.end(), rgb.begin(), rgb.end());
+  }
+  if (!writeFile(outPath, out)) { fprintf(stderr, "cannot write %s\n", outPath); return 1; }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc >= 4 && !strcmp(argv[1], "build")) { return build(argv[2], argc - 3, argv + 3); }
+  if (argc == 3 && !strcmp(argv[1], "info")) { return info(argv[2]); }
+  if (argc == 5 && !strcmp(argv[1], "play")) { return play(argv[2], argv[3], argv[4]); }
+  fprintf(stderr, "usage: animtool build <anim.bin> <name>:<fps>:<strips>:<frames.rgb> ...\n"
+                  "       animtool info <anim.bin>\n"
+                  "       animtool play <anim.bin> <name> <out.rgb>\n");
+  return 2;
+}
@@ -0,0 +1,135 @@
+// Host emulator for the APA102/SK9822 frames built by src/clocked_strip.cpp.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/apa102emu.cpp src/clocked_strip.cpp -o apa102emu
+//   ./apa102emu
+//
+// Encodes random frames with clockedEncode() into a capture buffer, exactly
+// the bytes the slave hands to Adafruit_SPIDevice::write(), and clocks them
+// through an emulated chain bit by bit. Each pixel waits for a start frame,
+// keeps the first 32-bit word that begins with 111 and passes everything
+// after it on, half a clock late (APA102); a pixel that runs out of clock
+// edges before its word is complete shows stale data. SK9822 pixels only
+// show a new word once 32 zero bits follow it. The shown colours must equal
+// the stored ones at full scale, and with a power scale set, brightness x
+// colour must be within one step of the scaled value. Also reports encode
+// time and the wire time per frame at the usual SPI clocks, next to WS2812.
+// Exits non-zero on any mismatch.
+#include "clocked_strip.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#define WS2812_US_PER_PIXEL 30.0  // 24 bits at 800 kHz
+#define WS2812_LATCH_US     300.0
+
+struct Shown {
+  uint8_t brightness, b, g, r;
+  bool valid;
+};
+
+// Returns the bits of the capture MSB first.
+static std::vector<uint8_t> bits(const std::vector<uint8_t>& capture) {
+  std::vector<uint8_t> out;
+  for (uint8_t byte : capture) {
+    for (int i = 7; i >= 0; i--) { out.push_back((byte >> i) & 1); }
+  }
+  return out;
+}
+
+// Pixel p sees the stream p/2 clocks late (APA102) and after the words of the
+// p pixels before it. It needs its own word in full before the clock stops,
+// and on SK9822 another 32 zero bits to latch it.
+static std::vector<Shown> chain(const std::vector<uint8_t>& stream, uint16_t numPixels, bool sk9822) {
+  std::vector<Shown> shown(numPixels, Shown{0, 0, 0, 0, false});
+  size_t pos = 0, zeros = 0;
+  while (pos < stream.size() && !(zeros >= 32 && stream[pos])) { zeros = stream[pos++] ? 0 : zeros + 1; }
+  for (uint16_t p = 0; p < numPixels; p++) {
+    size_t start = pos + (size_t)p * 32, delay = p / 2, end = start + 32;
+    if (end + delay > stream.size()) { break; }             // Clock stopped before the word was in
+    uint32_t word = 0;
+    for (size_t i = start; i < end; i++) { word = (word << 1) | stream[i]; }
+    if ((word >> 29) != 7) { break; }                       // Not a pixel header
+    if (sk9822) {
+      size_t tail = 0;
+      for (size_t i = start + (size_t)(numPixels - p) * 32; i < stream.size() && !stream[i]; i++) { tail++; }
+      if (tail < 32 + delay) { continue; }                  // Never latched
+    }
+    shown[p] = Shown{(uint8_t)((word >> 24) & 0x1F), (uint8_t)(word >> 16), (uint8_t)(word >> 8), (uint8_t)word, true};
+  }
+  return shown;
+}
+
+template <typename F> static double timeUs(int reps, F f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++) { f(r); }
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / reps;
+}
+
+int main() {
+  const uint16_t SIZES[] = {1, 30, 90, 300, 1000};
+  const uint16_t SCALES[] = {256, 200, 128, 40, 8, 1, 0};
+  const uint32_t CLOCKS[] = {10000000, CLOCKED_DEFAULT_HZ, 40000000};
+  uint32_t failures = 0;
+  srand(1);
+  for (uint16_t pixels : SIZES) {
+    std::vector<uint8_t> bgr(pixels * 3), capture(clockedFrameBytes(pixels));
+    uint32_t errors = 0, levels8 = 0, levelsClocked = 0;
+    for (uint16_t scale : SCALES) {
+      for (int f = 0; f < 20; f++) {
+        for (auto& b : bgr) { b = rand(); }
+        if (f == 0) { memset(bgr.data(), 0xFF, bgr.size()); }
+        clockedEncode(bgr.data(), pixels, scale, capture.data());
+        std::vector<uint8_t> stream = bits(capture);
+        for (int sk = 0; sk < 2; sk++) {
+          std::vector<Shown> shown = chain(stream, pixels, sk);
+          for (uint16_t p = 0; p < pixels; p++) {
+            if (!shown[p].valid) { errors++; continue; }
+            const uint8_t* in = &bgr[p * 3];
+            const uint8_t out[3] = {shown[p].b, shown[p].g, shown[p].r};
+            for (int c = 0; c < 3; c++) {
+              double want = in[c] * scale / 256.0;
+              double got = out[c] * shown[p].brightness / (double)CLOCKED_MAX_BRIGHTNESS;
+              if (got > want + 0.001 || got < want - 1.0 - in[c] / 256.0) { errors++; }
+            }
+          }
+        }
+      }
+      if (scale == 8) {
+        // Distinct output levels of a 0-255 ramp: plain 8-bit scaling as on
+        // WS2812, against global brightness first.
+        std::vector<bool> seen8(256), seenClocked(256 * 32);
+        for (int v = 0; v < 256; v++) {
+          uint8_t px[3] = {(uint8_t)v, 0, 0};
+          uint8_t frame[16];
+          clockedEncode(px, 1, scale, frame);
+          seen8[(v * scale) >> 8] = true;
+          seenClocked[(frame[4] & 0x1F) * 256 + frame[5]] = true;
+        }
+        for (bool s : seen8) { levels8 += s; }
+        for (bool s : seenClocked) { levelsClocked += s; }
+      }
+    }
+    double encode = timeUs(pixels > 300 ? 2000 : 20000, [&](int r) {
+      bgr[0] = r;
+      clockedEncode(bgr.data(), pixels, 256, capture.data());
+    });
+    double scaled = timeUs(pixels > 300 ? 2000 : 20000, [&](int r) {
+      bgr[0] = r;
+      clockedEncode(bgr.data(), pixels, 100, capture.data());
+    });
+    printf("%4u px: %s, %5u bytes, encode %.2f us (scaled %.2f us), ramp at 1/32 power: %u levels vs %u at 8 bits\n",
+           pixels, errors ? "FAIL" : "ok", (uint32_t)capture.size(), encode, scaled, levelsClocked, levels8);
+    printf("        wire");
+    for (uint32_t hz : CLOCKS) {
+      double us = capture.size() * 8 * 1e6 / hz;
+      printf(" %2u MHz %7.1f us (%5.0f fps),", hz / 1000000, us, 1e6 / us);
+    }
+    double ws = pixels * WS2812_US_PER_PIXEL + WS2812_LATCH_US;
+    printf(" WS2812 %7.1f us (%4.0f fps)\n", ws, 1e6 / ws);
+    failures += errors;
+  }
+  printf(failures ? "%u errors\n" : "all frames decoded by APA102 and SK9822 chains\n", failures);
+  return failures ? 1 : 0;
+}
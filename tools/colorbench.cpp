@@ -0,0 +1,258 @@
+// Golden test and benchmark for the batch colour kernels in Adafruit_NeoPixel.
+//
+//   g++ -std=c++17 -O2 -DARDUINO=100 -DESP32 -Itools/host "-Ilib/Adafruit NeoPixel" tools/colorbench.cpp "lib/Adafruit NeoPixel/Adafruit_NeoPixel.cpp" -o colorbench
+//   ./colorbench
+//
+// referenceHSV() below is the per-pixel ColorHSV() the library shipped with
+// before the kernels were added. Every hue x saturation x value must give
+// the same colour from it, from ColorHSV() and from the batch ColorHSV().
+// gamma32() works byte by byte, so every 24-bit colour (with a varying top
+// byte) goes through the scalar and batch versions and gamma8() on each
+// byte; sine8() is checked for all 256 angles, also in place.
+// setPixelsHSV() must leave the same bytes as setPixelColor(gamma32(
+// ColorHSV())) per pixel on RGB and RGBW strips at several brightnesses,
+// and rainbow() the same as the old per-pixel loop. Then reports the time
+// per 300-pixel frame for each pair. Exits non-zero on any mismatch. The
+// 2^32 HSV inputs take most of the run, about a minute and a half on a
+// desktop.
+#include <Adafruit_NeoPixel.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#define BENCH_PIXELS 300
+#define HUE_CHUNK    32768  // Batch counts are 16-bit
+
+extern "C" void espShow(uint16_t, uint8_t*, uint32_t, uint8_t) {}
+
+static uint32_t referenceHSV(uint16_t hue, uint8_t sat, uint8_t val) {
+  uint8_t r, g, b;
+  hue = (hue * 1530L + 32768) / 65536;
+  if (hue < 510) {
+    b = 0;
+    if (hue < 255) { r = 255; g = hue; }
+    else { r = 510 - hue; g = 255; }
+  } else if (hue < 1020) {
+    r = 0;
+    if (hue < 765) { g = 255; b = hue - 510; }
+    else { g = 1020 - hue; b = 255; }
+  } else if (hue < 1530) {
+    g = 0;
+    if (hue < 1275) { r = hue - 1020; b = 255; }
+    else { r = 255; b = 1530 - hue; }
+  } else {
+    r = 255;
+    g = b = 0;
+  }
+  uint32_t v1 = 1 + val;
+  uint16_t s1 = 1 + sat;
+  uint8_t s2 = 255 - sat;
+  return ((((((r * s1) >> 8) + s2) * v1) & 0xff00) << 8) |
+         (((((g * s1) >> 8) + s2) * v1) & 0xff00) |
+         (((((b * s1) >> 8) + s2) * v1) >> 8);
+}
+
+// The rainbow() loop the library shipped with.
+static void referenceRainbow(Adafruit_NeoPixel& strip, uint16_t firstHue, int8_t reps, uint8_t sat, uint8_t val, bool gammify) {
+  uint16_t pixels = strip.numPixels();
+  for (uint16_t i = 0; i < pixels; i++) {
+    uint16_t hue = firstHue + (i * reps * 65536) / pixels;
+    uint32_t color = referenceHSV(hue, sat, val);
+    if (gammify) { color = Adafruit_NeoPixel::gamma32(color); }
+    strip.setPixelColor(i, color);
+  }
+}
+
+static bool checkHSV() {
+  std::vector<uint16_t> hue(HUE_CHUNK);
+  std::vector<uint8_t> sat(HUE_CHUNK), val(HUE_CHUNK);
+  std::vector<uint32_t> batch(HUE_CHUNK), batchFull(HUE_CHUNK);
+  for (uint32_t s = 0; s < 256; s++) {
+    for (uint32_t v = 0; v < 256; v++) {
+      for (uint32_t first = 0; first < 65536; first += HUE_CHUNK) {
+        for (uint32_t i = 0; i < HUE_CHUNK; i++) { hue[i] = first + i; }
+        std::fill(sat.begin(), sat.end(), s);
+        std::fill(val.begin(), val.end(), v);
+        Adafruit_NeoPixel::ColorHSV(batch.data(), hue.data(), sat.data(), val.data(), HUE_CHUNK);
+        bool full = s == 255 && v == 255;  // NULL sat and val arrays mean 255
+        if (full) { Adafruit_NeoPixel::ColorHSV(batchFull.data(), hue.data(), NULL, NULL, HUE_CHUNK); }
+        for (uint32_t i = 0; i < HUE_CHUNK; i++) {
+          uint32_t expected = referenceHSV(hue[i], s, v);
+          uint32_t single = Adafruit_NeoPixel::ColorHSV(hue[i], s, v);
+          if (single != expected || batch[i] != expected || (full && batchFull[i] != expected)) {
+            printf("FAIL ColorHSV(%u, %u, %u): reference %06x, single %06x, batch %06x\n", hue[i], s, v,
+                   (unsigned)expected, (unsigned)single, (unsigned)batch[i]);
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool checkGammaSine() {
+  std::vector<uint32_t> colors(HUE_CHUNK);
+  for (uint32_t first = 0; first < 0x1000000; first += HUE_CHUNK) {
+    for (uint32_t i = 0; i < HUE_CHUNK; i++) { colors[i] = ((first + i) * 0x9Eu << 24) | (first + i); }
+    std::vector<uint32_t> batch = colors;
+    Adafruit_NeoPixel::gamma32(batch.data(), HUE_CHUNK);
+    for (uint32_t i = 0; i < HUE_CHUNK; i++) {
+      uint32_t c = colors[i];
+      uint32_t expected = ((uint32_t)Adafruit_NeoPixel::gamma8(c >> 24) << 24) |
+                          ((uint32_t)Adafruit_NeoPixel::gamma8(c >> 16) << 16) |
+                          ((uint32_t)Adafruit_NeoPixel::gamma8(c >> 8) << 8) | Adafruit_NeoPixel::gamma8(c);
+      if (Adafruit_NeoPixel::gamma32(c) != expected || batch[i] != expected) {
+        printf("FAIL gamma32(%08x): expected %08x, single %08x, batch %08x\n", (unsigned)c, (unsigned)expected,
+               (unsigned)Adafruit_NeoPixel::gamma32(c), (unsigned)batch[i]);
+        return false;
+      }
+    }
+  }
+  uint8_t angles[256], sines[256];
+  for (uint16_t x = 0; x < 256; x++) { angles[x] = x; }
+  Adafruit_NeoPixel::sine8(sines, angles, 256);
+  Adafruit_NeoPixel::sine8(angles, angles, 256);
+  for (uint16_t x = 0; x < 256; x++) {
+    if (sines[x] != Adafruit_NeoPixel::sine8(x) || angles[x] != sines[x]) {
+      printf("FAIL sine8(%u): single %u, batch %u, in place %u\n", x, Adafruit_NeoPixel::sine8(x), sines[x], angles[x]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkStrips() {
+  bool ok = true;
+  std::vector<uint16_t> hue(BENCH_PIXELS);
+  std::vector<uint8_t> sat(BENCH_PIXELS), val(BENCH_PIXELS);
+  for (uint16_t i = 0; i < BENCH_PIXELS; i++) {
+    hue[i] = i * 2184 + 77;
+    sat[i] = 150 + i % 106;
+    val[i] = 40 + i % 216;
+  }
+  for (neoPixelType type : { NEO_GRB + NEO_KHZ800, NEO_RGBW + NEO_KHZ800 }) {
+    uint8_t bpp = type == NEO_RGBW + NEO_KHZ800 ? 4 : 3;
+    for (uint16_t pixels : { 1, 7, 30, 90, 300 }) {
+      for (uint8_t brightness : { 0, 40, 255 }) {
+        Adafruit_NeoPixel batch(pixels, 4, type), single(pixels, 4, type);
+        if (brightness) {
+          batch.setBrightness(brightness);
+          single.setBrightness(brightness);
+        }
+        for (bool gammify : { false, true }) {
+          batch.fill(0x5A5A5A5A);  // Stale white bytes must be cleared
+          single.fill(0x5A5A5A5A);
+          batch.setPixelsHSV(0, pixels, hue.data(), sat.data(), val.data(), gammify);
+          for (uint16_t i = 0; i < pixels; i++) {
+            uint32_t color = Adafruit_NeoPixel::ColorHSV(hue[i], sat[i], val[i]);
+            single.setPixelColor(i, gammify ? Adafruit_NeoPixel::gamma32(color) : color);
+          }
+          if (memcmp(batch.getPixels(), single.getPixels(), pixels * bpp) != 0) {
+            printf("FAIL setPixelsHSV, %u px, %u bpp, brightness %u, gamma %d\n", pixels, bpp, brightness, gammify);
+            ok = false;
+          }
+          for (int8_t reps : { -5, -1, 0, 1, 3 }) {
+            for (uint16_t firstHue : { 0, 12345, 65535 }) {
+              batch.rainbow(firstHue, reps, 200, 255, gammify);
+              referenceRainbow(single, firstHue, reps, 200, 255, gammify);
+              if (memcmp(batch.getPixels(), single.getPixels(), pixels * bpp) != 0) {
+                printf("FAIL rainbow(%u, %d), %u px, %u bpp, brightness %u, gamma %d\n", firstHue, reps, pixels, bpp,
+                       brightness, gammify);
+                ok = false;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return ok;
+}
+
+static double frameUs(std::chrono::steady_clock::time_point start, uint32_t frames) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+static volatile uint32_t benchSink;
+
+static void benchmark() {
+  Adafruit_NeoPixel strip(BENCH_PIXELS, 4, NEO_GRB + NEO_KHZ800);
+  std::vector<uint16_t> hue(BENCH_PIXELS);
+  std::vector<uint8_t> sat(BENCH_PIXELS), val(BENCH_PIXELS), angles(BENCH_PIXELS);
+  std::vector<uint32_t> colors(BENCH_PIXELS);
+  for (uint16_t i = 0; i < BENCH_PIXELS; i++) {
+    hue[i] = i * 2184;
+    sat[i] = 200 + i % 50;
+    val[i] = 100 + i % 150;
+    angles[i] = i;
+  }
+  const uint32_t frames = 20000;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    hue[0] = f;
+    for (uint16_t i = 0; i < BENCH_PIXELS; i++) {
+      strip.setPixelColor(i, Adafruit_NeoPixel::gamma32(Adafruit_NeoPixel::ColorHSV(hue[i], sat[i], val[i])));
+    }
+  }
+  double perPixel = frameUs(start, frames);
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    hue[0] = f;
+    strip.setPixelsHSV(0, BENCH_PIXELS, hue.data(), sat.data(), val.data(), true);
+  }
+  printf("%d px: setPixelColor(gamma32(ColorHSV())) %.2f us, setPixelsHSV() %.2f us\n", BENCH_PIXELS, perPixel,
+         frameUs(start, frames));
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    referenceRainbow(strip, f, 1, 255, 255, true);
+  }
+  perPixel = frameUs(start, frames);
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) { strip.rainbow(f, 1, 255, 255, true); }
+  printf("%d px: per-pixel rainbow %.2f us, rainbow() %.2f us\n", BENCH_PIXELS, perPixel, frameUs(start, frames));
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    hue[0] = f;
+    for (uint16_t i = 0; i < BENCH_PIXELS; i++) { colors[i] = Adafruit_NeoPixel::gamma32(Adafruit_NeoPixel::ColorHSV(hue[i])); }
+    benchSink = colors[f % BENCH_PIXELS];
+  }
+  perPixel = frameUs(start, frames);
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    hue[0] = f;
+    Adafruit_NeoPixel::ColorHSV(colors.data(), hue.data(), NULL, NULL, BENCH_PIXELS);
+    Adafruit_NeoPixel::gamma32(colors.data(), BENCH_PIXELS);
+    benchSink = colors[f % BENCH_PIXELS];
+  }
+  printf("%d px: ColorHSV() + gamma32() per colour %.2f us, on arrays %.2f us\n", BENCH_PIXELS, perPixel,
+         frameUs(start, frames));
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    angles[0] = f;
+    for (uint16_t i = 0; i < BENCH_PIXELS; i++) { val[i] = Adafruit_NeoPixel::sine8(angles[i]); }
+    benchSink = val[f % BENCH_PIXELS];
+  }
+  perPixel = frameUs(start, frames);
+  start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    angles[0] = f;
+    Adafruit_NeoPixel::sine8(val.data(), angles.data(), BENCH_PIXELS);
+    benchSink = val[f % BENCH_PIXELS];
+  }
+  printf("%d px: sine8() per angle %.2f us, on an array %.2f us\n", BENCH_PIXELS, perPixel, frameUs(start, frames));
+}
+
+int main() {
+  bool ok = checkHSV();
+  ok &= checkGammaSine();
+  ok &= checkStrips();
+  printf("batch colour kernels: %s\n", ok ? "ok" : "FAILED");
+  benchmark();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Host unit tests for the command table parser in src/command.cpp.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/command_test.cpp src/command.cpp -o command_test
+//   ./command_test
+//
+// Runs lines through commandRun() against a table shaped like the slave's,
+// with handlers that record what they parsed, and checks the dispatch,
+// argument counts, the strict number and address parsers and the replies.
+// malloc() and operator new are counted (glibc), and running the lines must
+// not allocate at all. Exits non-zero on any failure.
+#include "command.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <string>
+
+extern "C" void* __libc_malloc(size_t size);
+static size_t allocations = 0;
+extern "C" void* malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+void* operator new(size_t size) {
+  allocations++;
+  return __libc_malloc(size ? size : 1);
+}
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; } } while (0)
+
+static char replyText[4096];
+static size_t replyLength = 0;
+static void capture(void*, const char* text, size_t length) {
+  if (replyLength + length >= sizeof(replyText)) { length = sizeof(replyText) - 1 - replyLength; }
+  memcpy(replyText + replyLength, text, length);
+  replyLength += length;
+  replyText[replyLength] = '\0';
+}
+static CommandReply reply = { capture, nullptr };
+
+static const char* ran = "";
+static long number = -1;
+static uint8_t address[4];
+static bool parsed = false;
+
+static void onSetIp(const CommandArgs& args, CommandReply&) { ran = "SET_IP"; parsed = commandArgIp(args, 0, address); }
+static void onSetPort(const CommandArgs& args, CommandReply&) { ran = "SET_INPORT"; parsed = commandArgInt(args, 0, 1, 65535, number); }
+static void onSetDmx(const CommandArgs& args, CommandReply& r) {
+  ran = "SET_DMX";
+  parsed = commandArgIs(args, 0, "artnet") && (args.count < 2 || commandArgInt(args, 1, 0, 32767, number));
+  commandPrintf(r, "args %u\n", args.count);
+}
+static void onGet(const CommandArgs&, CommandReply& r) { ran = "GET"; commandPrint(r, "Device ID: 3\n"); }
+static void onImpostor(const CommandArgs&, CommandReply&) { ran = "IMPOSTOR"; }
+
+static const Command table[] = {
+  COMMAND("SET_IP",     1, 1, onSetIp,   "<ip_address>", "Set the device IP address"),
+  COMMAND("SET_INPORT", 1, 1, onSetPort, "<port_number>", "Set the input port"),
+  COMMAND("SET_DMX",    1, 3, onSetDmx,  "<off|artnet|sacn> [universe] [start]", "DMX input"),
+  { commandHash("GET"), "IMPOSTOR", 0, 0, onImpostor, "", "Same hash as GET, listed first" },
+  COMMAND("GET",        0, 0, onGet,     "", "Get current configuration"),
+};
+static const uint8_t COUNT = sizeof(table) / sizeof(table[0]);
+
+static CommandResult run(const char* line) {
+  ran = "";
+  parsed = false;
+  number = -1;
+  replyLength = 0;
+  replyText[0] = '\0';
+  return commandRun(table, COUNT, line, strlen(line), reply);
+}
+
+int main() {
+  CHECK(run("SET_IP 192.168.1.50") == COMMAND_OK && !strcmp(ran, "SET_IP") && parsed);
+  CHECK(address[0] == 192 && address[1] == 168 && address[2] == 1 && address[3] == 50);
+  CHECK(run("  set_ip\t10.0.0.7  \r") == COMMAND_OK && parsed && address[0] == 10 && address[3] == 7);
+  const char* badIps[] = { "1.2.3", "1.2.3.4.5", "256.1.1.1", "1..2.3", "1.2.3.4x", "a.b.c.d", "0001.2.3.4", "1.2.3.-4" };
+  for (const char* ip : badIps) {
+    std::string line = std::string("SET_IP ") + ip;
+    CHECK(run(line.c_str()) == COMMAND_OK && !parsed);
+  }
+
+  CHECK(run("SET_INPORT 7001") == COMMAND_OK && parsed && number == 7001);   // Was parsed from offset 10
+  CHECK(run("SET_INPORT +9000") == COMMAND_OK && parsed && number == 9000);
+  const char* badPorts[] = { "0", "65536", "-1", "12abc", "", "99999999999999999999", "+", "-" };
+  for (const char* port : badPorts) {
+    std::string line = std::string("SET_INPORT ") + port;
+    CommandResult result = run(line.c_str());
+    CHECK(!parsed && number == -1);
+    CHECK(result == (port[0] ? COMMAND_OK : COMMAND_USAGE));
+  }
+  CHECK(run("SET_INPORT7001") == COMMAND_UNKNOWN);
+
+  CHECK(run("SET_DMX artnet 3") == COMMAND_OK && parsed && number == 3 && !strcmp(replyText, "args 2\n"));
+  CHECK(run("SET_DMX ArtNet") == COMMAND_OK && parsed);
+  CHECK(run("SET_DMX artnets") == COMMAND_OK && !parsed);
+  CHECK(run("SET_DMX") == COMMAND_USAGE && !strcmp(ran, "") &&
+        !strcmp(replyText, "❌ Usage: SET_DMX <off|artnet|sacn> [universe] [start]\n"));
+  CHECK(run("SET_DMX artnet 1 1 1") == COMMAND_USAGE);
+  CHECK(run("SET_DMX a b c d e f g h") == COMMAND_USAGE);              // More than COMMAND_MAX_ARGS
+
+  CHECK(run("GET") == COMMAND_OK && !strcmp(ran, "GET") && !strcmp(replyText, "Device ID: 3\n"));
+  CHECK(run("get") == COMMAND_OK && !strcmp(ran, "GET"));                // Hash matches IMPOSTOR first, name does not
+  CHECK(run("GET x") == COMMAND_USAGE);
+  CHECK(run("GETX") == COMMAND_UNKNOWN && strstr(replyText, "GETX"));
+  CHECK(run("FORGET") == COMMAND_UNKNOWN);                              // Was run as GET
+  CHECK(run("") == COMMAND_EMPTY && replyLength == 0);
+  CHECK(run(" \t ") == COMMAND_EMPTY);
+
+  const char line[] = "GET and more";                                    // Only the span is read
+  CHECK(commandRun(table, COUNT, line, 3, reply) == COMMAND_OK && !strcmp(ran, "GET"));
+
+  replyLength = 0;
+  commandHelp(table, COUNT, reply);
+  CHECK(strstr(replyText, "SET_IP <ip_address> - Set the device IP address\n") && strstr(replyText, "GET - Get current"));
+
+  // Allocation count and speed over a mix of lines
+  const char* mix[] = { "SET_IP 192.168.1.50", "SET_INPORT 7001", "SET_DMX artnet 3 1", "GET", "nonsense", "SET_INPORT 12abc" };
+  const int reps = 200000;
+  allocations = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++) {
+    const char* l = mix[r % 6];
+    replyLength = 0;
+    commandRun(table, COUNT, l, strlen(l), reply);
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / reps;
+  size_t counted = allocations;
+  CHECK(counted == 0);
+
+  printf("%d failures, %zu allocations over %d lines, %.0f ns per line including the reply\n", failures, counted, reps, ns);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+// Quality and throughput test for the 16-bit output path: effectRender()
+// into Canvas::write16() with temporal dithering (src/canvas.cpp).
+//
+//   g++ -std=c++17 -O2 -Isrc -c src/effects.cpp -o effects.o
+//   g++ -std=c++17 -O2 -DARDUINO=100 -DESP32 -Isrc -Itools/host "-Ilib/Adafruit NeoPixel" "-Ilib/Adafruit BusIO" tools/dithertest.cpp effects.o src/canvas.cpp src/clocked_strip.cpp "lib/Adafruit NeoPixel/Adafruit_NeoPixel.cpp" "lib/Adafruit BusIO/Adafruit_SPIDevice.cpp" -o dithertest
+//   ./dithertest
+//
+// effects.cpp is built without ARDUINO, which leaves out the effect task and
+// keeps only effectRender().
+// Runs on the slave's usual layout of three 30-pixel strips. For static
+// 16-bit levels across the whole range, every dithered frame must be within
+// one 8-bit step of the level, and the average over 256 frames within
+// 1/256 of a step (the error is carried, never lost); without dithering the
+// output must be the nearest step. The same per-frame bound is checked on
+// every frame of a slow pulse and a countdown rendered by effectRender(),
+// and write16() must report a frame as exact only when every level is a
+// whole 8-bit step. Then times render and write16() per frame and adds
+// the WS2812 wire time and latch of one strip (the strips are sent in
+// parallel by RMT, and show() waits that long) to check the DITHER_FPS
+// budget of 4 ms per frame. Exits non-zero on any failure.
+#include "canvas.h"
+#include "effects.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#define STRIPS 3
+#define STRIP_PIXELS 30
+#define PIXELS (STRIPS * STRIP_PIXELS)
+#define AVERAGE_FRAMES 256
+#define WS2812_US_PER_PIXEL 30.0  // 24 bits at 800 kHz
+#define WS2812_LATCH_US 300.0
+
+extern "C" void espShow(uint16_t, uint8_t*, uint32_t, uint8_t) {}
+
+static uint8_t channel(uint32_t color, uint8_t c) { return color >> (16 - 8 * c); }
+
+// Largest distance of any channel from its 16-bit level, in 1/256 steps,
+// over every `stride`th pixel.
+static int32_t frameError(Canvas& canvas, const uint16_t* rgb, uint16_t stride = 1) {
+  int32_t worst = 0;
+  for (uint16_t i = 0; i < PIXELS; i += stride) {
+    uint32_t color = canvas.getPixel(i);
+    for (uint8_t c = 0; c < 3; c++) {
+      uint16_t level = rgb[i * 3 + c];
+      int32_t target = level - (level >> 8);           // The 0-65280 scale write16() works on
+      worst = std::max(worst, abs(channel(color, c) * 256 - target));
+    }
+  }
+  return worst;
+}
+
+static bool checkStatic(Canvas& canvas) {
+  bool ok = true;
+  std::vector<uint16_t> rgb(PIXELS * 3);
+  double worstAverage[2] = {}, worstFrame[2] = {};
+  for (uint8_t dither = 0; dither < 2; dither++) {
+    canvas.setDither(dither);
+    for (uint32_t level = 0; level <= 65535; level += 37) {
+      std::fill(rgb.begin(), rgb.end(), level);
+      int64_t sum = 0;
+      int32_t frameWorst = 0;
+      for (uint16_t f = 0; f < AVERAGE_FRAMES; f++) {
+        canvas.write16(0, rgb.data(), PIXELS);
+        frameWorst = std::max(frameWorst, frameError(canvas, rgb.data(), STRIP_PIXELS - 1)); // Spread over the strips
+        sum += channel(canvas.getPixel(PIXELS / 2), 1) * 256;
+      }
+      int32_t target = level - (level >> 8);
+      double average = std::abs((double)sum / AVERAGE_FRAMES - target) / 256;
+      worstAverage[dither] = std::max(worstAverage[dither], average);
+      worstFrame[dither] = std::max(worstFrame[dither], frameWorst / 256.0);
+      bool frameOk = dither ? frameWorst < 256 : frameWorst <= 128;
+      bool averageOk = !dither || average <= 1.0 / AVERAGE_FRAMES;
+      if (ok && (!frameOk || !averageOk)) {
+        printf("FAIL dither %s, level %u: frame error %.3f, average error %.4f steps\n", dither ? "on" : "off",
+               level, frameWorst / 256.0, average);
+      }
+      ok &= frameOk && averageOk;
+    }
+    printf("static levels, dither %-3s worst frame %.3f steps, worst %u-frame average %.4f steps\n",
+           dither ? "on" : "off", worstFrame[dither], AVERAGE_FRAMES, worstAverage[dither]);
+  }
+  return ok;
+}
+
+static bool checkEffects(Canvas& canvas) {
+  bool ok = true;
+  std::vector<uint16_t> rgb(PIXELS * 3);
+  canvas.setDither(true);
+  EffectState pulse = { EFFECT_PULSE, 12, 0xFF, 0x3060FF, 0, 4000 };       // Slow and dim, where steps show
+  EffectState countdown = { EFFECT_COUNTDOWN, 40, 0xFF, 0xFF2000, 0, 2000 };
+  for (const EffectState& state : { pulse, countdown }) {
+    int32_t worst = 0;
+    for (uint32_t ms = 0; ms < state.durationMs; ms += 1000 / DITHER_FPS) {
+      effectRender(state, ms, rgb.data(), PIXELS);
+      canvas.write16(0, rgb.data(), PIXELS);
+      worst = std::max(worst, frameError(canvas, rgb.data()));
+    }
+    printf("%-9s worst frame %.3f steps\n", effectName(state.type), worst / 256.0);
+    if (worst >= 256) {
+      printf("FAIL %s frames are more than one step off\n", effectName(state.type));
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+static bool checkExact(Canvas& canvas) {
+  std::vector<uint16_t> rgb(PIXELS * 3);
+  canvas.setDither(true);
+  bool ok = true;
+  for (uint16_t step = 0; step < 256; step++) {
+    std::fill(rgb.begin(), rgb.end(), step * 257);
+    ok &= canvas.write16(0, rgb.data(), PIXELS);
+    rgb[PIXELS] = step * 257 + 128;
+    ok &= !canvas.write16(0, rgb.data(), PIXELS);
+  }
+  if (!ok) { printf("FAIL write16() misreports exact frames\n"); }
+  return ok;
+}
+
+static bool checkBudget(Canvas& canvas) {
+  std::vector<uint16_t> rgb(PIXELS * 3);
+  canvas.setDither(true);
+  EffectState pulse = { EFFECT_PULSE, 255, 0xFF, 0xFFFFFF, 0, 500 };
+  const uint32_t frames = 200000;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t f = 0; f < frames; f++) {
+    effectRender(pulse, f % 500, rgb.data(), PIXELS);
+    canvas.write16(0, rgb.data(), PIXELS);
+  }
+  double cpuUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+  double wireUs = STRIP_PIXELS * WS2812_US_PER_PIXEL + WS2812_LATCH_US;
+  double budgetUs = 1000000.0 / DITHER_FPS;
+  printf("%d x %d px: render + write16 %.2f us (host), wire %.0f us, %.0f us budget at %d fps\n",
+         STRIPS, STRIP_PIXELS, cpuUs, wireUs, budgetUs, DITHER_FPS);
+  if (cpuUs + wireUs > budgetUs) {
+    printf("FAIL a dithered frame does not fit the %d fps period\n", DITHER_FPS);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  Canvas canvas;
+  for (uint8_t s = 0; s < STRIPS; s++) { canvas.addSegment(13 + s, STRIP_PIXELS); }
+  if (!canvas.begin() || !canvas.setDither(true)) {
+    printf("No memory for the canvas\n");
+    return 1;
+  }
+  bool ok = checkStatic(canvas);
+  ok &= checkEffects(canvas);
+  ok &= checkExact(canvas);
+  ok &= checkBudget(canvas);
+  printf("16-bit output and dithering: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
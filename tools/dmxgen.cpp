@@ -0,0 +1,234 @@
+// Art-Net and sACN (E1.31) packet generator for the decoder in src/dmx.cpp.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/dmxgen.cpp src/dmx.cpp -o dmxgen
+//   ./dmxgen [pixels] [first universe] [start]    default 900 3 4
+//
+// Patches a canvas of `pixels` RGB pixels the way a console would: the
+// first universe from DMX address `start`, every following one with 170
+// pixels from address 1. Random frames are sent through both protocols as
+// full packets (ArtDmx, E1.31 data with a sync address, ArtSync and E1.31
+// extended sync), decoded with artnetDecode() / e131Decode() and placed
+// with dmxMapUniverse() as dmxReceive() does, and the resulting pixels must
+// equal the frame. Packets the slave must ignore (preview data, alternate
+// start codes, short or foreign packets) must decode as nothing. Lists the
+// sACN multicast groups the slave joins for the canvas, then reports the
+// decode time per packet. Exits non-zero on any mismatch.
+#include "dmx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define E131_DATA_OFFSET 126
+
+static void put16(uint8_t* p, uint16_t v) { p[0] = v >> 8; p[1] = v; }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v >> 16); put16(p + 2, v); }
+static void putFlagsLength(uint8_t* p, size_t length) { put16(p, 0x7000 | length); } // E1.31 PDU header
+
+static std::vector<uint8_t> artnetDmx(uint16_t universe, uint8_t sequence, const std::vector<uint8_t>& slots) {
+  std::vector<uint8_t> p(18 + slots.size());
+  memcpy(p.data(), "Art-Net", 8);
+  p[9] = 0x50;                          // OpDmx, little endian
+  p[11] = 14;                           // Protocol version
+  p[12] = sequence;
+  p[14] = universe & 0xFF;              // Sub-Net and Universe
+  p[15] = (universe >> 8) & 0x7F;       // Net
+  put16(&p[16], slots.size());
+  memcpy(&p[18], slots.data(), slots.size());
+  return p;
+}
+
+static std::vector<uint8_t> artnetSync() {
+  std::vector<uint8_t> p(14);
+  memcpy(p.data(), "Art-Net", 8);
+  p[9] = 0x52;                          // OpSync
+  p[11] = 14;
+  return p;
+}
+
+static void e131Root(std::vector<uint8_t>& p, uint32_t vector) {
+  put16(&p[0], 0x0010);                 // Preamble size
+  memcpy(&p[4], "ASC-E1.17\0\0\0", 12);
+  putFlagsLength(&p[16], p.size() - 16);
+  put32(&p[18], vector);
+  memset(&p[22], 0xA5, 16);             // Sender CID
+}
+
+static std::vector<uint8_t> e131Data(uint16_t universe, uint8_t sequence, const std::vector<uint8_t>& slots,
+                                     uint16_t syncUniverse, uint8_t options = 0, uint8_t startCode = 0) {
+  std::vector<uint8_t> p(E131_DATA_OFFSET + slots.size());
+  e131Root(p, 0x00000004);
+  putFlagsLength(&p[38], p.size() - 38);
+  put32(&p[40], 0x00000002);            // Framing: DMP data
+  memcpy(&p[44], "dmxgen", 6);          // Source name, 64 bytes
+  p[108] = 100;                         // Priority
+  put16(&p[109], syncUniverse);
+  p[111] = sequence;
+  p[112] = options;
+  put16(&p[113], universe);
+  putFlagsLength(&p[115], p.size() - 115);
+  p[117] = 0x02;                        // DMP set property
+  p[118] = 0xA1;                        // Address and data types
+  put16(&p[121], 1);                    // Address increment
+  put16(&p[123], slots.size() + 1);     // Property count, with the start code
+  p[125] = startCode;
+  memcpy(&p[E131_DATA_OFFSET], slots.data(), slots.size());
+  return p;
+}
+
+static std::vector<uint8_t> e131Sync(uint16_t syncUniverse, uint8_t sequence) {
+  std::vector<uint8_t> p(49);
+  e131Root(p, 0x00000008);
+  putFlagsLength(&p[38], p.size() - 38);
+  put32(&p[40], 0x00000001);            // Framing: extended sync
+  p[44] = sequence;
+  put16(&p[45], syncUniverse);
+  return p;
+}
+
+// A console's patch: universe k of the canvas and its 512 slots.
+struct Patch {
+  uint16_t universe;
+  std::vector<uint8_t> slots;
+};
+
+static std::vector<Patch> patchFrame(const std::vector<uint8_t>& rgb, uint16_t firstUniverse, uint16_t start) {
+  std::vector<Patch> universes;
+  size_t pixel = 0, pixels = rgb.size() / 3;
+  for (uint16_t universe = firstUniverse; pixel < pixels; universe++) {
+    size_t slot = universe == firstUniverse ? start - 1 : 0;
+    size_t fit = std::min<size_t>((DMX_SLOTS - slot) / 3, pixels - pixel);
+    Patch patch = { universe, std::vector<uint8_t>(DMX_SLOTS) };
+    memcpy(&patch.slots[slot], &rgb[pixel * 3], fit * 3);
+    pixel += fit;
+    universes.push_back(patch);
+  }
+  return universes;
+}
+
+// Same placement as dmxReceive() in src/main.cpp, into a plain RGB canvas.
+static void receive(const DmxPacket& dmx, uint16_t firstUniverse, uint16_t start, std::vector<uint8_t>& canvas) {
+  uint16_t firstPixel, firstSlot, pixels = canvas.size() / 3;
+  if (!dmxMapUniverse(firstUniverse, start, dmx.universe, firstPixel, firstSlot)) { return; }
+  if (firstPixel >= pixels || firstSlot >= dmx.count) { return; }
+  uint16_t count = std::min<uint32_t>((dmx.count - firstSlot) / 3, pixels - firstPixel);
+  memcpy(&canvas[firstPixel * 3], dmx.slots + firstSlot, count * 3);
+}
+
+static bool checkFrames(uint16_t pixels, uint16_t firstUniverse, uint16_t start, std::mt19937& rng) {
+  bool ok = true;
+  for (uint8_t protocol : { DMX_ARTNET, DMX_SACN }) {
+    for (uint8_t sequence = 1; sequence <= 20 && ok; sequence++) {
+      std::vector<uint8_t> frame(pixels * 3), canvas(pixels * 3);
+      for (uint8_t& b : frame) { b = rng(); }
+      bool synced = false;
+      for (const Patch& patch : patchFrame(frame, firstUniverse, start)) {
+        std::vector<uint8_t> packet = protocol == DMX_ARTNET ? artnetDmx(patch.universe, sequence, patch.slots)
+                                                             : e131Data(patch.universe, sequence, patch.slots, 1);
+        DmxPacket dmx;
+        DmxKind kind = protocol == DMX_ARTNET ? artnetDecode(packet.data(), packet.size(), dmx)
+                                              : e131Decode(packet.data(), packet.size(), dmx);
+        if (kind != DMX_DATA || dmx.universe != patch.universe || dmx.count != DMX_SLOTS || dmx.sequence != sequence ||
+            dmx.waitForSync != (protocol == DMX_SACN)) {
+          printf("FAIL %s universe %u decoded as kind %d, universe %u, %u slots\n", dmxProtocolName(protocol),
+                 patch.universe, kind, dmx.universe, dmx.count);
+          ok = false;
+          break;
+        }
+        receive(dmx, firstUniverse, start, canvas);
+      }
+      std::vector<uint8_t> sync = protocol == DMX_ARTNET ? artnetSync() : e131Sync(1, sequence);
+      DmxPacket dmx;
+      synced = (protocol == DMX_ARTNET ? artnetDecode(sync.data(), sync.size(), dmx)
+                                       : e131Decode(sync.data(), sync.size(), dmx)) == DMX_SYNC;
+      if (!synced) {
+        printf("FAIL %s sync packet not recognised\n", dmxProtocolName(protocol));
+        ok = false;
+      }
+      if (ok && canvas != frame) {
+        size_t i = std::mismatch(canvas.begin(), canvas.end(), frame.begin()).first - canvas.begin();
+        printf("FAIL %s frame %u: pixel %zu differs from the frame sent\n", dmxProtocolName(protocol), sequence, i / 3);
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+static bool checkIgnored() {
+  std::vector<uint8_t> slots(DMX_SLOTS, 0x55);
+  struct Case { const char* name; std::vector<uint8_t> packet; bool sacn; };
+  std::vector<Case> cases = {
+    { "E1.31 preview data", e131Data(1, 0, slots, 0, 0x80), true },
+    { "E1.31 alternate start code", e131Data(1, 0, slots, 0, 0, 0xDD), true },
+    { "E1.31 cut short", e131Data(1, 0, slots, 0), true },
+    { "Art-Net cut short", artnetDmx(1, 0, slots), false },
+    { "Art-Net packet as E1.31", artnetDmx(1, 0, slots), true },
+    { "E1.31 packet as Art-Net", e131Data(1, 0, slots, 0), false },
+  };
+  cases[2].packet.resize(cases[2].packet.size() - 10);
+  cases[3].packet.resize(cases[3].packet.size() - 10);
+  bool ok = true;
+  for (const Case& c : cases) {
+    DmxPacket dmx;
+    DmxKind kind = c.sacn ? e131Decode(c.packet.data(), c.packet.size(), dmx) : artnetDecode(c.packet.data(), c.packet.size(), dmx);
+    if (kind != DMX_NONE) {
+      printf("FAIL %s decoded as kind %d\n", c.name, kind);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// The groups dmxBegin() joins: every universe that maps onto the canvas.
+static void listGroups(uint16_t pixels, uint16_t firstUniverse, uint16_t start) {
+  printf("sACN groups for %u pixels from universe %u, address %u:", pixels, firstUniverse, start);
+  uint16_t firstPixel, firstSlot;
+  for (uint16_t universe = firstUniverse; dmxMapUniverse(firstUniverse, start, universe, firstPixel, firstSlot) && firstPixel < pixels; universe++) {
+    printf(" 239.255.%u.%u", universe >> 8, universe & 0xFF);
+  }
+  printf("\n");
+}
+
+static volatile uint8_t benchSink;
+
+static void benchmark(uint16_t firstUniverse) {
+  std::vector<uint8_t> slots(DMX_SLOTS - 2, 0x42);
+  std::vector<uint8_t> artnet = artnetDmx(firstUniverse, 1, slots), e131 = e131Data(firstUniverse, 1, slots, 0);
+  const uint32_t packets = 5000000;
+  DmxPacket dmx;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < packets; i++) {
+    artnetDecode(artnet.data(), artnet.size(), dmx);
+    benchSink = dmx.slots[i & 255];
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < packets; i++) {
+    e131Decode(e131.data(), e131.size(), dmx);
+    benchSink = dmx.slots[i & 255];
+  }
+  auto end = std::chrono::steady_clock::now();
+  printf("decode, 510 slots: Art-Net %.1f ns/packet, E1.31 %.1f ns/packet\n",
+         std::chrono::duration<double, std::nano>(middle - start).count() / packets,
+         std::chrono::duration<double, std::nano>(end - middle).count() / packets);
+}
+
+int main(int argc, char** argv) {
+  uint16_t pixels = argc > 1 ? atoi(argv[1]) : 900;
+  uint16_t firstUniverse = argc > 2 ? atoi(argv[2]) : 3;
+  uint16_t start = argc > 3 ? atoi(argv[3]) : 4;
+  if (pixels == 0 || start < 1 || start > DMX_SLOTS - 2) {
+    printf("Use 1 or more pixels and a start address of 1-510\n");
+    return 1;
+  }
+  std::mt19937 rng(1);
+  bool ok = checkFrames(pixels, firstUniverse, start, rng);
+  ok &= checkIgnored();
+  printf("Art-Net and sACN frames: %s\n", ok ? "ok" : "FAILED");
+  listGroups(pixels, firstUniverse, start);
+  benchmark(firstUniverse);
+  return ok ? 0 : 1;
+}
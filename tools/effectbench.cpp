@@ -0,0 +1,156 @@
+// Snapshot test and benchmark for the effect renderer in src/effects.cpp.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/effectbench.cpp src/effects.cpp -o effectbench
+//   ./effectbench            check the snapshots, then time every effect
+//   ./effectbench snapshots  print the snapshot table for the current renderer
+//
+// Renders every effect on a 30-pixel strip at fixed times through
+// effectRender(), the same call the effect task makes, and compares an
+// FNV-1a hash of each 16-bit frame with the table below. After an
+// intentional change to an effect, check the new frames on a strip and
+// paste the output of `effectbench snapshots` over SNAPSHOTS. Also checks
+// that timed effects end on time, then reports the render cost per frame at
+// 30, 300 and 1000 pixels as a share of the 20 ms frame period. Times are
+// host times; expect the ESP32 to be an order of magnitude slower. Exits
+// non-zero on any mismatch.
+#include "effects.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#define SNAPSHOT_PIXELS 30
+#define SNAPSHOT_TIMES  6
+
+static const uint32_t SNAPSHOT_MS[SNAPSHOT_TIMES] = { 0, 45, 120, 250, 380, 499 };
+
+struct Snapshot {
+  uint8_t type;
+  uint32_t durationMs;
+  uint32_t hash[SNAPSHOT_TIMES];
+};
+
+static const Snapshot SNAPSHOTS[] = {
+  { EFFECT_SOLID,     0,    { 0x091e0149, 0x091e0149, 0x091e0149, 0x091e0149, 0x091e0149, 0x091e0149 } },
+  { EFFECT_PULSE,     500,  { 0x9267a459, 0xe74d3e29, 0xa4bf4791, 0x091e0149, 0xfd4b7881, 0x9267a459 } },
+  { EFFECT_CHASE,     0,    { 0x15e1eecc, 0xd2ec969c, 0x64453588, 0xd8105744, 0xf284ddd4, 0x6342b724 } },
+  { EFFECT_COUNTDOWN, 500,  { 0x091e0149, 0x25bf2ced, 0xf174a23c, 0x6bed6dac, 0xd89db9a5, 0x78b3f770 } },
+  { EFFECT_FLASH,     0,    { 0x091e0149, 0x091e0149, 0x67e36cd5, 0x091e0149, 0x67e36cd5, 0x091e0149 } },
+};
+
+static EffectState makeState(uint8_t type, uint32_t durationMs) {
+  EffectState state = {};
+  state.type = type;
+  state.brightness = 200;
+  state.frame = 0xFF;
+  state.color = 0xFF8020;
+  state.startMs = 1000;
+  state.durationMs = durationMs;
+  return state;
+}
+
+static uint32_t fnv1a(const uint16_t* values, size_t count) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < count; i++) {
+    hash = (hash ^ (values[i] & 0xFF)) * 16777619u;
+    hash = (hash ^ (values[i] >> 8)) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t renderHash(const EffectState& state, uint32_t atMs, std::vector<uint16_t>& rgb) {
+  std::fill(rgb.begin(), rgb.end(), 0xA5A5);  // Anything not rendered shows up in the hash
+  effectRender(state, state.startMs + atMs, rgb.data(), SNAPSHOT_PIXELS);
+  return fnv1a(rgb.data(), rgb.size());
+}
+
+static void printSnapshots() {
+  std::vector<uint16_t> rgb(SNAPSHOT_PIXELS * 3);
+  for (const Snapshot& s : SNAPSHOTS) {
+    EffectState state = makeState(s.type, s.durationMs);
+    char type[24];
+    snprintf(type, sizeof(type), "EFFECT_%s,", effectName(s.type));
+    for (char* c = type; *c; c++) { if (*c >= 'a' && *c <= 'z') { *c -= 'a' - 'A'; } }
+    char duration[12];
+    snprintf(duration, sizeof(duration), "%u,", (unsigned)s.durationMs);
+    printf("  { %-17s %-5s {", type, duration);
+    for (uint8_t t = 0; t < SNAPSHOT_TIMES; t++) {
+      printf(" 0x%08x%s", (unsigned)renderHash(state, SNAPSHOT_MS[t], rgb), t + 1 < SNAPSHOT_TIMES ? "," : "");
+    }
+    printf(" } },\n");
+  }
+}
+
+static bool checkSnapshots() {
+  std::vector<uint16_t> rgb(SNAPSHOT_PIXELS * 3);
+  bool ok = true;
+  for (const Snapshot& s : SNAPSHOTS) {
+    EffectState state = makeState(s.type, s.durationMs);
+    for (uint8_t t = 0; t < SNAPSHOT_TIMES; t++) {
+      uint32_t hash = renderHash(state, SNAPSHOT_MS[t], rgb);
+      if (hash != s.hash[t]) {
+        printf("FAIL %s at %u ms: hash 0x%08x, expected 0x%08x\n", effectName(s.type),
+               (unsigned)SNAPSHOT_MS[t], (unsigned)hash, (unsigned)s.hash[t]);
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+// Timed effects report false from their end time on; untimed ones never do.
+static bool checkEndings() {
+  std::vector<uint16_t> rgb(SNAPSHOT_PIXELS * 3);
+  bool ok = true;
+  for (uint8_t type = 0; type < EFFECT_COUNT; type++) {
+    EffectState timed = makeState(type, 400);
+    bool before = effectRender(timed, timed.startMs + 399, rgb.data(), SNAPSHOT_PIXELS);
+    bool after = effectRender(timed, timed.startMs + 400, rgb.data(), SNAPSHOT_PIXELS);
+    if (!before || after) {
+      printf("FAIL %s with 400 ms: running %d at 399 ms, %d at 400 ms\n", effectName(type), before, after);
+      ok = false;
+    }
+  }
+  for (uint8_t type : { EFFECT_SOLID, EFFECT_CHASE, EFFECT_FLASH }) {
+    EffectState forever = makeState(type, 0);
+    if (!effectRender(forever, forever.startMs + 3600000, rgb.data(), SNAPSHOT_PIXELS)) {
+      printf("FAIL %s without a duration ended\n", effectName(type));
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+static volatile uint16_t benchSink;  // Keeps the rendered frames alive
+
+static void benchmark() {
+  const uint32_t periodUs = 1000000 / EFFECTS_FPS;
+  for (uint16_t pixels : { 30, 300, 1000 }) {
+    std::vector<uint16_t> rgb(pixels * 3);
+    printf("%4u px:", pixels);
+    for (uint8_t type = 0; type < EFFECT_COUNT; type++) {
+      EffectState state = makeState(type, 0);
+      const uint32_t frames = 2000000 / pixels;
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t f = 0; f < frames; f++) {
+        effectRender(state, state.startMs + f * 7 % 450, rgb.data(), pixels);
+        benchSink = rgb[f % rgb.size()];
+      }
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+      printf("  %s %.2f us (%.3f%%)", effectName(type), us, us * 100 / periodUs);
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "snapshots") == 0) {
+    printSnapshots();
+    return 0;
+  }
+  bool ok = checkSnapshots();
+  ok &= checkEndings();
+  printf("snapshots and endings: %s\n", ok ? "ok" : "FAILED");
+  benchmark();
+  return ok ? 0 : 1;
+}
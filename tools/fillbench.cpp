@@ -0,0 +1,142 @@
+// Benchmark and check for Adafruit_NeoPixel::fill() and dirty tracking.
+//
+//   g++ -std=c++17 -O2 -DARDUINO=100 -DESP32 -Itools/host "-Ilib/Adafruit NeoPixel" tools/fillbench.cpp "lib/Adafruit NeoPixel/Adafruit_NeoPixel.cpp" -o fillbench
+//   ./fillbench
+//
+// Builds the patched library against the host shim in tools/host; espShow()
+// below stands in for the RMT driver and counts the frames it is handed.
+// For 30, 300 and 1000 pixels, with brightness set, fill() must leave the
+// same bytes as a setPixelColor() loop, for the whole strip and for a
+// partial range, and the time per fill is reported for both. Then show()
+// must only send when the pixels changed, and a write made while a frame
+// is being sent (another task writing during the blocking RMT write) must
+// be sent by the next show(). Last, getLevelSum() must equal the sum of
+// the buffer after every kind of write, on RGB and RGBW strips. Exits
+// non-zero on any mismatch.
+#include <Adafruit_NeoPixel.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+
+static uint32_t shows;
+static std::function<void()> duringShow;  // Runs inside the next espShow()
+
+extern "C" void espShow(uint16_t pin, uint8_t* pixels, uint32_t numBytes, uint8_t type) {
+  (void)pin; (void)pixels; (void)numBytes; (void)type;
+  shows++;
+  if (duringShow) {
+    auto write = duringShow;
+    duringShow = nullptr;
+    write();
+  }
+}
+
+static void fillLoop(Adafruit_NeoPixel& strip, uint32_t color, uint16_t first = 0, uint16_t count = 0) {
+  uint16_t end = count ? first + count : strip.numPixels();
+  for (uint16_t i = first; i < end; i++) { strip.setPixelColor(i, color); }
+}
+
+static bool sameBytes(Adafruit_NeoPixel& a, Adafruit_NeoPixel& b, const char* what, uint16_t pixels) {
+  if (memcmp(a.getPixels(), b.getPixels(), pixels * 3) == 0) { return true; }
+  printf("FAIL %u px: fill() differs from setPixelColor() %s\n", pixels, what);
+  return false;
+}
+
+static bool benchmark(uint16_t pixels) {
+  Adafruit_NeoPixel looped(pixels, 4, NEO_GRB + NEO_KHZ800), filled(pixels, 4, NEO_GRB + NEO_KHZ800);
+  looped.setBrightness(128);
+  filled.setBrightness(128);
+  const uint32_t iterations = 20000000 / pixels;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) { fillLoop(looped, 0x123456 + i); }
+  auto middle = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) { filled.fill(0x123456 + i); }
+  auto end = std::chrono::steady_clock::now();
+  bool ok = sameBytes(looped, filled, "on the whole strip", pixels);
+
+  fillLoop(looped, 0);
+  fillLoop(looped, 0x00FF00, 5, 7);
+  filled.fill(0x00FF00, 5, 7);
+  filled.fill(0, 0, 5);
+  filled.fill(0, 12);
+  ok &= sameBytes(looped, filled, "on pixels 5-11", pixels);
+
+  double loopNs = std::chrono::duration<double, std::nano>(middle - start).count() / iterations;
+  double fillNs = std::chrono::duration<double, std::nano>(end - middle).count() / iterations;
+  printf("%4u px: setPixelColor loop %8.1f ns, fill() %7.1f ns (%.1fx)\n", pixels, loopNs, fillNs, loopNs / fillNs);
+  return ok;
+}
+
+static bool checkDirty() {
+  Adafruit_NeoPixel strip(30, 4, NEO_GRB + NEO_KHZ800);
+  strip.fill(0x102030);
+  shows = 0;
+  strip.show();
+  strip.show();
+  strip.show();
+  bool ok = shows == 1;
+  if (!ok) { printf("FAIL unchanged pixels were sent again (%u sends for 3 show() calls)\n", shows); }
+
+  duringShow = [&strip] { strip.setPixelColor(3, 0xFF0000); };
+  strip.fill(0x000040);
+  shows = 0;
+  strip.show();  // The write lands while this frame is out
+  strip.show();
+  if (shows != 2) {
+    printf("FAIL a write during show() was not sent by the next show() (%u sends)\n", shows);
+    ok = false;
+  }
+  return ok;
+}
+
+static uint32_t byteSum(Adafruit_NeoPixel& strip, uint8_t bpp) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < strip.numPixels() * bpp; i++) { sum += strip.getPixels()[i]; }
+  return sum;
+}
+
+static bool checkLevelSums() {
+  bool ok = true;
+  for (neoPixelType type : { NEO_GRB + NEO_KHZ800, NEO_RGBW + NEO_KHZ800 }) {
+    uint8_t bpp = type == NEO_RGBW + NEO_KHZ800 ? 4 : 3;
+    Adafruit_NeoPixel strip(60, 4, type);
+    strip.setBrightness(100);
+    uint16_t hue[10] = { 0, 7000, 14000, 21000, 28000, 35000, 42000, 49000, 56000, 63000 };
+    struct Step { const char* name; std::function<void()> write; };
+    const Step steps[] = {
+      { "whole fill", [&] { strip.fill(0x11223344); } },
+      { "setPixelColor", [&] { strip.setPixelColor(5, 0xFF00FF); } },
+      { "RGBW setPixelColor", [&] { strip.setPixelColor(6, 1, 2, 3, 4); } },
+      { "partial fill", [&] { strip.fill(0x808080, 10, 20); } },
+      { "setPixelsHSV", [&] { strip.setPixelsHSV(40, 10, hue, NULL, NULL, true); } },
+      { "setBrightness", [&] { strip.setBrightness(30); } },
+      { "direct write", [&] { strip.getPixels()[7] = 200; strip.markDirty(); } },
+      { "write after whole fill", [&] {  // The fill's own sum must not hide it
+          strip.fill(0x010101);
+          strip.setPixelColor(59, 0xFFFFFF);
+        } },
+      { "clear", [&] { strip.clear(); } },
+      { "write after clear", [&] { strip.setPixelColor(0, 0x0000FF); } },
+    };
+    for (const Step& step : steps) {
+      step.write();
+      if (strip.getLevelSum() != byteSum(strip, bpp)) {
+        printf("FAIL %u bpp, after %s: level sum %u, buffer sums to %u\n", bpp, step.name,
+               (unsigned)strip.getLevelSum(), (unsigned)byteSum(strip, bpp));
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+int main() {
+  bool ok = true;
+  for (uint16_t pixels : { 30, 300, 1000 }) { ok &= benchmark(pixels); }
+  ok &= checkDirty();
+  ok &= checkLevelSums();
+  printf("fill, dirty tracking and level sums: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
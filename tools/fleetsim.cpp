@@ -0,0 +1,181 @@
+// Simulated fleet of slaves for tools/provision.cpp, on local UDP sockets.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/fleetsim.cpp src/fleet.cpp src/config.cpp src/command.cpp src/osc_view.cpp src/dmx.cpp -o fleetsim
+//   ./fleetsim [slaves] [--port 7001] [--seconds 30] [--loss percent] [--seed n]
+//
+// Every simulated slave binds its own socket to the OSC port, so a broadcast
+// reaches all of them, and answers /discover, /provision and /config/set the
+// way src/main.cpp does, with the slave's own fleet.cpp and config.cpp: one
+// change per message or bundle, a single NVS write for it, broadcast replies
+// to the sender's port, and a restart (here 1.5 s of silence) when network
+// settings change. Slaves start with factory settings: no device ID and all
+// on the same address. The strip layout is not checked, there are no pins.
+// --loss drops that share of packets in each direction. At the end each
+// slave's settings and NVS write count are printed.
+#include "fleet.h"
+#include "osc_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#define FIRMWARE_VERSION "1.1.0-sim"
+#define RESTART_DELAY_MS 100
+#define BOOT_MS          1500     // Restart until Ethernet is up again
+
+struct SimSlave {
+  int fd;
+  uint8_t mac[6];
+  DeviceConfig config;           // Settings in use, as in the globals of main.cpp
+  uint8_t activeIp[4];           // Address the network was started with
+  uint32_t writes = 0;           // NVS blob writes
+  double bootMs = 0, restartAtMs = -1;
+};
+
+static std::mt19937 rng;
+static double lossPercent = 0;
+static bool lost() { return std::uniform_real_distribution<double>(0, 100)(rng) < lossPercent; }
+
+static double nowMs() {
+  static auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static DeviceConfig factoryConfig() {
+  DeviceConfig c = {};
+  c.deviceId = 10;                                 // Not set, as loadConfig() leaves it
+  const uint8_t ip[4] = {192, 168, 1, 101}, subnet[4] = {255, 255, 255, 0}, gateway[4] = {192, 168, 1, 1}, outIp[4] = {192, 168, 1, 99};
+  memcpy(c.ip, ip, 4);
+  memcpy(c.subnet, subnet, 4);
+  memcpy(c.gateway, gateway, 4);
+  memcpy(c.outIp, outIp, 4);
+  c.inPort = 7001;
+  c.outPort = 7000;
+  c.dmxStart = 1;
+  c.strips[0] = {13, -1, 30};
+  c.strips[1] = {14, -1, 30};
+  c.strips[2] = {33, -1, 30};
+  c.strips[3] = {-1, -1, 0};
+  configSeal(c);
+  return c;
+}
+
+static void reply(SimSlave& s, const OscOut& msg, uint16_t port) {
+  if (lost()) { return; }
+  udpSend(s.fd, msg.bytes(), udpAddress("255.255.255.255", port));
+}
+
+static std::string ipText(const uint8_t* a) {
+  char text[16];
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", a[0], a[1], a[2], a[3]);
+  return text;
+}
+
+// changeConfig() and oscConfigAck() of main.cpp
+static void change(SimSlave& s, DeviceConfig next, const char* problem, bool configSet, bool provisioned, uint16_t port) {
+  std::string result = problem ? problem : "will be saved";
+  if (!problem) {
+    configSeal(next);
+    bool network = memcmp(next.ip, s.config.ip, 4) || memcmp(next.subnet, s.config.subnet, 4) ||
+                   memcmp(next.gateway, s.config.gateway, 4) || next.inPort != s.config.inPort;
+    if (memcmp(&next, &s.config, sizeof(next)) != 0) { s.writes++; } // configSave() skips unchanged records
+    s.config = next;
+    if (network && provisioned) {
+      s.restartAtMs = nowMs() + RESTART_DELAY_MS;
+      result = "will be saved, restarting";
+    }
+    else if (network) { result = "will be saved, network settings apply after a restart"; }
+  }
+  char mac[FLEET_MAC_TEXT];
+  fleetMacText(s.mac, mac);
+  if (configSet) { reply(s, OscOut("/config/ack").add(s.config.deviceId).add(!problem).add(result), port); }
+  if (provisioned) { reply(s, OscOut("/provision/ack").add(mac).add(!problem).add(result), port); }
+}
+
+static void receive(SimSlave& s, const uint8_t* packet, int size, uint16_t port) {
+  DeviceConfig next = s.config;
+  const char* problem = nullptr;
+  bool configSet = false, provisioned = false;
+  auto message = [&](const uint8_t* data, int length) {
+    OSCView view;
+    if (!oscViewParse(data, length, view)) { return; }
+    if (!strcmp(view.address, "/discover")) {
+      char mac[FLEET_MAC_TEXT];
+      fleetMacText(s.mac, mac);
+      reply(s, OscOut("/discover/reply").add(mac).add(s.config.deviceId).add(ipText(s.activeIp))
+                                        .add(FIRMWARE_VERSION).add((int32_t)(nowMs() - s.bootMs)), port);
+    }
+    else if (!strcmp(view.address, "/config/set")) {
+      if (!problem) { problem = fleetApplyFields(view, 0, next); }
+      configSet = true;
+    }
+    else if (!strcmp(view.address, "/provision") && fleetForMe(view, s.mac)) {
+      if (!problem) { problem = fleetApplyFields(view, 1, next); }
+      provisioned = true;
+    }
+  };
+  if (packet[0] == '#') {
+    const uint8_t* element;
+    int elementSize, offset = 0;
+    while (oscBundleNext(packet, size, offset, element, elementSize)) { message(element, elementSize); }
+  }
+  else { message(packet, size); }
+  if (configSet || provisioned) { change(s, next, problem, configSet, provisioned, port); }
+}
+
+int main(int argc, char** argv) {
+  int count = 8, port = 7001;
+  double seconds = 30;
+  uint32_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc) { port = atoi(argv[++i]); }
+    else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) { seconds = atof(argv[++i]); }
+    else if (!strcmp(argv[i], "--loss") && i + 1 < argc) { lossPercent = atof(argv[++i]); }
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) { seed = atoi(argv[++i]); }
+    else { count = atoi(argv[i]); }
+  }
+  rng.seed(seed);
+  std::vector<SimSlave> slaves(count);
+  std::vector<pollfd> fds;
+  for (SimSlave& s : slaves) {
+    s.fd = udpOpen(port);
+    if (s.fd < 0) { perror("bind"); return 1; }
+    const uint8_t oui[3] = {0x24, 0x0A, 0xC4};     // Espressif
+    memcpy(s.mac, oui, 3);
+    for (int b = 3; b < 6; b++) { s.mac[b] = rng(); }
+    s.config = factoryConfig();
+    memcpy(s.activeIp, s.config.ip, 4);
+    fds.push_back({s.fd, POLLIN, 0});
+    char mac[FLEET_MAC_TEXT];
+    fleetMacText(s.mac, mac);
+    printf("slave %s on port %d\n", mac, port);
+  }
+  fflush(stdout);
+  uint8_t packet[1472];
+  while (nowMs() < seconds * 1000) {
+    poll(fds.data(), fds.size(), 10);
+    for (size_t i = 0; i < slaves.size(); i++) {
+      SimSlave& s = slaves[i];
+      if (s.restartAtMs >= 0 && nowMs() >= s.restartAtMs) {          // ESP.restart()
+        s.restartAtMs = -1;
+        s.bootMs = nowMs() + BOOT_MS;
+        memcpy(s.activeIp, s.config.ip, 4);
+      }
+      if (!(fds[i].revents & POLLIN)) { continue; }
+      sockaddr_in from = {};
+      socklen_t length = sizeof(from);
+      int size = recvfrom(s.fd, packet, sizeof(packet), 0, (sockaddr*)&from, &length);
+      if (size <= 0 || nowMs() < s.bootMs || lost()) { continue; }    // Booting, or lost on the way
+      receive(s, packet, size, ntohs(from.sin_port));
+    }
+  }
+  for (SimSlave& s : slaves) {
+    char mac[FLEET_MAC_TEXT];
+    fleetMacText(s.mac, mac);
+    printf("%s  id %2u  ip %-15s  NVS writes %u\n", mac, s.config.deviceId, ipText(s.activeIp).c_str(), s.writes);
+  }
+  return 0;
+}
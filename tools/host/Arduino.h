@@ -0,0 +1,52 @@
+// Minimal Arduino core for building firmware modules into the host tools.
+// Enough for Adafruit_NeoPixel, Adafruit_SPIDevice and the src/ modules the
+// tools link; pins and timing are no-ops and micros()/millis() are real.
+// The tool supplies espShow(), which receives every NeoPixel frame.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(4, 4, 0)
+
+typedef bool boolean;
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define IRAM_ATTR
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return 0; }
+inline void delayMicroseconds(uint32_t) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline uint32_t micros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t millis() { return micros() / 1000; }
+inline bool psramFound() { return false; }
+inline void* ps_calloc(size_t n, size_t size) { return calloc(n, size); }
+
+inline volatile uint32_t* hostPort() { static volatile uint32_t port; return &port; }
+inline int digitalPinToPort(int) { return 0; }
+inline volatile uint32_t* portOutputRegister(int) { return hostPort(); }
+inline volatile uint32_t* portInputRegister(int) { return hostPort(); }
+inline uint32_t digitalPinToBitMask(int pin) { return 1u << (pin & 31); }
+
+using std::max;
+using std::min;
+
+#endif
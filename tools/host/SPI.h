@@ -0,0 +1,43 @@
+// SPI bus for the host tools: transfers are dropped; clocked strips are
+// checked through clockedEncode() by tools/apa102emu.cpp instead.
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+#define SPI_MSBFIRST MSBFIRST
+#define SPI_LSBFIRST LSBFIRST
+#define HSPI 2
+#define VSPI 3
+
+struct SPISettings {
+  SPISettings(uint32_t hz = 0, uint8_t = 0, uint8_t = 0) : hz(hz) {}
+  uint32_t hz;
+};
+
+class SPIClass {
+public:
+  SPIClass(uint8_t bus = VSPI) : bus(bus) {}
+  void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+  void end() {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction() {}
+  void setFrequency(uint32_t) {}
+  void setBitOrder(uint8_t) {}
+  void setDataMode(uint8_t) {}
+  uint8_t transfer(uint8_t) { return 0; }
+  void transfer(void*, uint32_t) {}
+  void transferBytes(const uint8_t*, uint8_t*, uint32_t) {}
+  void writeBytes(const uint8_t*, uint32_t) {}
+
+private:
+  uint8_t bus;
+};
+
+inline SPIClass SPI;
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA      8
+#define MALLOC_CAP_INTERNAL 2048
+
+inline void* heap_caps_malloc(size_t n, int) { return malloc(n); }
+inline void heap_caps_free(void* p) { free(p); }
+
+#endif
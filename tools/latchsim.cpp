@@ -0,0 +1,124 @@
+// Host simulator for frame-latch synchronisation across slaves (src/latch.h).
+//
+//   g++ -std=c++17 -O2 -Isrc tools/latchsim.cpp src/latch.cpp -o latchsim
+//   ./latchsim [slaves] [minutes]
+//
+// Runs the slave side of the protocol against simulated clocks and
+// networks and reports the skew, meaning the spread of the moments the
+// slaves start show() for the same frame, under four strategies:
+//   effect now   /effect/... shown at the slave's next 50 fps tick (no latch)
+//   pixels now   /pixels shown as soon as the slave's loop reads the packet
+//   latch now    frame staged, then /latch without a time
+//   latch timed  frame staged, then /latch <master_us> 20 ms ahead
+// Each slave has its own boot offset, a crystal error of up to +-20 ppm, a
+// broadcast delivery delay, a loop() that reaches oscReceive() some time
+// after the packet arrives (with occasional multi-millisecond stalls, e.g.
+// Bluetooth), a 1 ms scheduler tick and a render time before show(). The
+// clock estimate is the slave's own code: latchClockSample() and
+// latchClockToLocal() from src/latch.cpp, fed with 32-bit micros() that wrap
+// during long runs.
+#include "latch.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define TIME_PERIOD_US    100000  // Master /time broadcast, 10 Hz
+#define FRAME_PERIOD_US   1000000 // One synchronised frame per second
+#define LATCH_AHEAD_US    20000   // Timed latch target after the send
+#define EFFECT_PERIOD_US  20000   // 1000 / EFFECTS_FPS
+#define TICK_US           1000    // FreeRTOS tick
+#define LEAD_US           3000    // LATCH_LEAD_US in effects.cpp
+#define WAKE_US           15      // Task notify to running
+#define SPIN_EXIT_US      2       // micros() resolution and loop exit
+
+struct Slave {
+  double offsetUs;   // Local clock at master time 0
+  double rate;       // Local seconds per master second
+  double tickPhase;  // Effect frame phase, 0-1
+  double renderUs;   // Render time before show(), depends on the effect and strip length
+  LatchClock clock = {};
+  uint32_t local(double masterUs) const { return (uint32_t)(int64_t)llround(offsetUs + masterUs * rate); }
+  double master(double localUs) const { return (localUs - offsetUs) / rate; }
+};
+
+static std::mt19937_64 rng(1);
+static double uniform(double a, double b) { return std::uniform_real_distribution<double>(a, b)(rng); }
+static double exponential(double mean) { return std::exponential_distribution<double>(1.0 / mean)(rng); }
+
+static double network() { return 60 + exponential(20); }          // Switch plus lwIP, per slave
+static double loopDelay() {                                         // Packet read by loop() after arrival
+  double d = uniform(0, 300);
+  if (uniform(0, 1) < 0.05) { d += uniform(500, 5000); }            // Bluetooth, Ethernet events, Serial
+  return d;
+}
+
+struct Skew {
+  const char* name;
+  std::vector<double> values;
+  void add(const std::vector<double>& shown) {
+    auto mm = std::minmax_element(shown.begin(), shown.end());
+    values.push_back(*mm.second - *mm.first);
+  }
+  void print() {
+    std::sort(values.begin(), values.end());
+    auto at = [&](double q) { return values[(size_t)(q * (values.size() - 1))]; };
+    printf("  %-12s p50 %8.1f us   p99 %8.1f us   max %8.1f us\n", name, at(0.5), at(0.99), values.back());
+  }
+};
+
+int main(int argc, char** argv) {
+  int count = argc > 1 ? atoi(argv[1]) : 8;
+  double minutes = argc > 2 ? atof(argv[2]) : 120;
+  std::vector<Slave> slaves(count);
+  for (Slave& s : slaves) {
+    s.offsetUs = uniform(0, 4e9);                                   // Booted at different times, wraps soon
+    s.rate = 1 + uniform(-20e-6, 20e-6);
+    s.tickPhase = uniform(0, 1);
+    s.renderUs = uniform(150, 400);
+  }
+  Skew skews[4] = {{"effect now", {}}, {"pixels now", {}}, {"latch now", {}}, {"latch timed", {}}};
+  double worstClock = 0;
+  uint32_t late = 0, frames = 0;
+  double end = minutes * 60e6;
+  double nextFrame = 30e6;                                          // Let the clocks settle first
+  for (double t = 0; t < end; t += TIME_PERIOD_US) {
+    for (Slave& s : slaves) {                                       // /time broadcast
+      double arrive = t + network() + loopDelay();
+      latchClockSample(s.clock, (uint32_t)(int64_t)t, s.local(arrive));
+    }
+    if (t < nextFrame) { continue; }
+    nextFrame += FRAME_PERIOD_US;
+    frames++;
+    double send = t + TIME_PERIOD_US / 2;
+    std::vector<double> shown[4];
+    for (Slave& s : slaves) {
+      double arrive = send + network(), read = arrive + loopDelay();
+      // No latch: an effect starts at the next frame tick, streamed pixels at once
+      double readLocal = s.offsetUs + read * s.rate;                 // Ticks run on the slave's own clock
+      double tick = EFFECT_PERIOD_US * (ceil(readLocal / EFFECT_PERIOD_US - s.tickPhase) + s.tickPhase);
+      shown[0].push_back(s.master(tick) + s.renderUs);
+      shown[1].push_back(read + WAKE_US + s.renderUs);
+      // Latch without a time: due on arrival, so show() follows the render
+      double latchRead = std::max(read, send + 500 + network() + loopDelay()); // /latch sent 500 us after the frame
+      shown[2].push_back(latchRead + WAKE_US + s.renderUs + SPIN_EXIT_US);
+      // Timed latch: convert, sleep in whole ticks until LEAD_US before, render, spin
+      uint32_t target = latchClockToLocal(s.clock, (uint32_t)(int64_t)(send + LATCH_AHEAD_US));
+      double targetMaster = s.master(s.offsetUs + send * s.rate + (int32_t)(target - s.local(send)));
+      double wake = std::max(latchRead, targetMaster - LEAD_US);
+      wake = TICK_US * ceil(wake / TICK_US) + WAKE_US;              // vTaskDelay ends on a tick
+      double ready = wake + s.renderUs;
+      if (ready > targetMaster) { late++; }
+      shown[3].push_back(std::max(ready, targetMaster) + SPIN_EXIT_US);
+      worstClock = std::max(worstClock, fabs(targetMaster - (send + LATCH_AHEAD_US)));
+    }
+    for (int k = 0; k < 4; k++) { skews[k].add(shown[k]); }
+  }
+  printf("%d slaves, %.0f minutes, %u synchronised frames, /time at %d Hz\n", count, minutes, frames, 1000000 / TIME_PERIOD_US);
+  for (Skew& s : skews) { s.print(); }
+  printf("  timed latch: worst clock error %.1f us, %u of %u slave frames rendered late\n",
+         worstClock, late, frames * count);
+  return 0;
+}
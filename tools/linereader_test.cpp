@@ -0,0 +1,143 @@
+// Host test for the Bluetooth line assembler in src/line_reader.cpp.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/linereader_test.cpp src/line_reader.cpp -o linereader_test
+//   ./linereader_test
+//
+// Replays Bluetooth traffic against readBTSerial()'s loop: commands cut at
+// random points into packets, CRLF and LF endings, characters typed one at a
+// time in a terminal, pauses in the middle of a line and lines too long for
+// the buffer. A pass may only read what available() reported at its start;
+// reading from an empty stream (which is where readStringUntil() waits)
+// counts as blocking the loop. Every command must come out once, whole and
+// in order, and overlong lines must be dropped without eating the next one.
+// For comparison it also reports how long the old readStringUntil('\n')
+// would have held loop() on the same traffic, with the 1 s Stream timeout.
+// Exits non-zero on any failure.
+#include "line_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#define LOOP_US          200      // One loop() pass without traffic
+#define STREAM_TIMEOUT_US 1000000 // Stream::setTimeout() default
+
+struct Chunk {
+  double atUs;                    // Arrival time
+  std::string bytes;
+};
+
+// Bytes arrive chunk by chunk; available() only counts what has arrived.
+struct FakeStream {
+  std::vector<Chunk> chunks;
+  size_t chunk = 0, pos = 0;
+  double nowUs = 0;
+  uint32_t emptyReads = 0;
+  int available() {
+    int n = 0;
+    for (size_t c = chunk; c < chunks.size() && chunks[c].atUs <= nowUs; c++) {
+      n += chunks[c].bytes.size() - (c == chunk ? pos : 0);
+    }
+    return n;
+  }
+  int read() {
+    if (chunk >= chunks.size() || chunks[chunk].atUs > nowUs) {
+      emptyReads++;
+      return -1;
+    }
+    int c = (uint8_t)chunks[chunk].bytes[pos++];
+    if (pos == chunks[chunk].bytes.size()) {
+      chunk++;
+      pos = 0;
+    }
+    return c;
+  }
+  bool done() const { return chunk >= chunks.size(); }
+};
+
+static std::mt19937 rng(1);
+static int uniform(int a, int b) { return std::uniform_int_distribution<int>(a, b)(rng); }
+
+int main() {
+  const char* COMMANDS[] = { "SET_IP 192.168.1.50", "SET_ID 3", "GET", "STATS", "SET_STRIP 2 4 60",
+                             "SET_DMX artnet 1 1", "HELP", "SET_POWER 2500", "SET_GATEWAY 192.168.1.1" };
+  std::vector<std::string> sent;
+  std::vector<Chunk> chunks;
+  double t = 0;
+  uint32_t longLines = 0;
+  for (int i = 0; i < 20000; i++) {
+    std::string line = COMMANDS[uniform(0, 8)];
+    bool tooLong = uniform(0, 49) == 0;
+    if (tooLong) { line = std::string(uniform(LINE_READER_SIZE, 400), 'X'); longLines++; }
+    else { sent.push_back(line); }
+    line += uniform(0, 1) ? "\r\n" : "\n";
+    int style = uniform(0, 9);
+    size_t at = 0;
+    while (at < line.size()) {
+      size_t n = style == 0 ? 1 : (size_t)uniform(1, (int)line.size());        // Typed, or cut into packets
+      t += style == 0 ? uniform(80000, 300000) : uniform(0, 20000);
+      if (style == 1 && at > 0 && uniform(0, 3) == 0) { t += uniform(500000, 3000000); } // Sender paused mid line
+      chunks.push_back({t, line.substr(at, n)});
+      at += n;
+    }
+  }
+
+  // New: one pass per loop(), only what is available.
+  FakeStream stream{chunks};
+  LineReader reader = {};
+  std::vector<std::string> received;
+  int mostBytes = 0;
+  uint64_t passes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  while (!stream.done()) {
+    int available = stream.available();
+    mostBytes = std::max(mostBytes, available);
+    while (available-- > 0) {
+      const char* line = lineReaderPut(reader, stream.read());
+      if (line && line[0]) { received.push_back(line); }
+    }
+    passes++;
+    stream.nowUs += LOOP_US;
+  }
+  double passNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / passes;
+  bool linesOk = received == sent;
+  bool ok = linesOk && stream.emptyReads == 0 && reader.dropped == longLines;
+
+  // Old: readStringUntil('\n') waits for each missing byte up to the timeout.
+  double oldWorstUs = 0, oldTotalUs = 0;
+  uint32_t oldTimeouts = 0;
+  {
+    FakeStream old{chunks};
+    while (!old.done()) {
+      if (old.available()) {
+        double start = old.nowUs;
+        for (;;) {
+          if (!old.available()) {
+            size_t c = old.chunk;
+            if (c >= old.chunks.size() || old.chunks[c].atUs - old.nowUs > STREAM_TIMEOUT_US) {
+              old.nowUs += STREAM_TIMEOUT_US;  // Gave up, the partial line is run as a command
+              oldTimeouts++;
+              break;
+            }
+            old.nowUs = old.chunks[c].atUs;
+          }
+          if (old.read() == '\n') { break; }
+        }
+        oldWorstUs = std::max(oldWorstUs, old.nowUs - start);
+        oldTotalUs += old.nowUs - start;
+      }
+      old.nowUs += LOOP_US;
+    }
+  }
+
+  printf("%zu commands, %u overlong lines, %zu packets over %.0f s of traffic\n", sent.size(), longLines, chunks.size(), t / 1e6);
+  printf("  line reader: %s, %zu lines out, %u dropped, %u reads from an empty stream, %llu passes\n"
+         "               at most %d bytes per pass, %.0f ns per pass including the fake stream\n",
+         linesOk ? "ok" : "FAIL", received.size(), reader.dropped, stream.emptyReads, (unsigned long long)passes, mostBytes, passNs);
+  printf("  readStringUntil: loop held %.1f s in total, worst %.0f ms, %u partial lines run after the timeout\n",
+         oldTotalUs / 1e6, oldWorstUs / 1e3, oldTimeouts);
+  return ok ? 0 : 1;
+}
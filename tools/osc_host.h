@@ -0,0 +1,98 @@
+// OSC encoding and UDP sockets for the host tools. Packets are read with
+// src/osc_view.cpp, the same parser the slave uses.
+#ifndef OSC_HOST_H
+#define OSC_HOST_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+struct OscOut {
+  std::string address, types = ",";
+  std::vector<uint8_t> args;
+
+  explicit OscOut(const std::string& a) : address(a) {}
+  OscOut& add(int32_t v) {
+    types += 'i';
+    for (int s = 24; s >= 0; s -= 8) { args.push_back((uint32_t)v >> s); }
+    return *this;
+  }
+  OscOut& add(const std::string& v) {
+    types += 's';
+    pad(args, v);
+    return *this;
+  }
+  OscOut& add(const std::vector<uint8_t>& blob) {
+    types += 'b';
+    for (int s = 24; s >= 0; s -= 8) { args.push_back((uint32_t)blob.size() >> s); }
+    args.insert(args.end(), blob.begin(), blob.end());
+    while (args.size() & 3) { args.push_back(0); }
+    return *this;
+  }
+  std::vector<uint8_t> bytes() const {
+    std::vector<uint8_t> out;
+    pad(out, address);
+    pad(out, types);
+    out.insert(out.end(), args.begin(), args.end());
+    return out;
+  }
+  static void pad(std::vector<uint8_t>& out, const std::string& s) {
+    out.insert(out.end(), s.begin(), s.end());
+    do { out.push_back(0); } while (out.size() & 3);
+  }
+};
+
+// "#bundle", an immediate time tag, then each message with its size.
+inline std::vector<uint8_t> oscBundle(const std::vector<std::vector<uint8_t>>& messages) {
+  std::vector<uint8_t> out = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0, 0, 0, 0, 0, 0, 0, 0, 1};
+  for (const auto& m : messages) {
+    for (int s = 24; s >= 0; s -= 8) { out.push_back((uint32_t)m.size() >> s); }
+    out.insert(out.end(), m.begin(), m.end());
+  }
+  return out;
+}
+
+// Broadcast-capable UDP socket. Several sockets may share a port, and each
+// of them receives the broadcasts sent to it, as every slave on a LAN would.
+inline int udpOpen(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  local.sin_port = htons(port);
+  if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+inline uint16_t udpPort(int fd) {
+  sockaddr_in local = {};
+  socklen_t length = sizeof(local);
+  getsockname(fd, (sockaddr*)&local, &length);
+  return ntohs(local.sin_port);
+}
+
+inline bool udpSend(int fd, const std::vector<uint8_t>& data, const sockaddr_in& to) {
+  return sendto(fd, data.data(), data.size(), 0, (const sockaddr*)&to, sizeof(to)) == (ssize_t)data.size();
+}
+
+inline sockaddr_in udpAddress(const char* host, uint16_t port) {
+  sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(port);
+  inet_pton(AF_INET, host, &to.sin_addr);
+  return to;
+}
+
+#endif
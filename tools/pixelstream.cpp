@@ -0,0 +1,238 @@
+// Throughput test for /pixels streaming (src/main.cpp) over local UDP.
+//
+//   g++ -std=c++17 -O2 -DARDUINO=100 -DESP32 -Isrc -Itools/host "-Ilib/Adafruit NeoPixel" "-Ilib/Adafruit BusIO" tools/pixelstream.cpp src/osc_view.cpp src/pixel_delta.cpp src/canvas.cpp src/clocked_strip.cpp "lib/Adafruit NeoPixel/Adafruit_NeoPixel.cpp" "lib/Adafruit BusIO/Adafruit_SPIDevice.cpp" -o pixelstream
+//   ./pixelstream [--frames 2000]
+//
+// A stand-in master streams random frames as /pixels blobs to a stand-in
+// slave on a loopback socket. The slave reads each datagram into one
+// OSC_PACKET_SIZE buffer and decodes it with src/osc_view.cpp straight into
+// a real Canvas, as oscReceivePixels() does (staging and the LED task are
+// left out). Three layouts are run: 3 x 30 pixels in one packet per frame,
+// 3 x 30 with one packet per strip (strip index and offset), and 3 x 300
+// with one packet per strip, since a 900-pixel frame does not fit one
+// datagram. After every frame the canvas must hold exactly the sent
+// colours. Reports packets and frames per second for the whole path and
+// the time spent in the decode and canvas write alone, against the 60 fps
+// the master aims for. Last, a keyframe and a delta are followed by a /fill
+// and another delta: the slave must drop that delta and ask for a keyframe,
+// since the frame it was made against is gone. Exits non-zero on a
+// mismatch or a lost packet.
+#include "canvas.h"
+#include "osc_host.h"
+#include "osc_view.h"
+#include "pixel_delta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define OSC_PACKET_SIZE 1472  // As in src/main.cpp
+#define RECEIVE_TIMEOUT_MS 200
+#define TARGET_FPS 60
+
+extern "C" void espShow(uint16_t, uint8_t*, uint32_t, uint8_t) {}
+
+// Mirrors oscReceivePixels() in src/main.cpp, with the parse and address
+// check oscReceive() and oscReceiveMessage() do before it.
+static bool receivePixels(Canvas& canvas, const uint8_t* packet, int size) {
+  OSCView view;
+  if (!oscViewParse(packet, size, view) || strcmp(view.address, "/pixels") != 0) { return false; }
+  const uint8_t* rgb;
+  uint32_t bytes;
+  int32_t offset = 0, strip = -1;
+  if (!oscViewBlob(view, 0, rgb, bytes)) { return true; }
+  oscViewInt(view, 1, offset);
+  oscViewInt(view, 2, strip);
+  uint32_t count = bytes / 3;
+  if (strip >= 0) {
+    if (strip >= canvas.segmentCount() || offset < 0) { return true; }
+    uint16_t length = canvas.segment(strip).numPixels();
+    if ((uint32_t)offset >= length) { return true; }
+    count = std::min<uint32_t>(count, length - offset);
+    offset += canvas.segmentStart(strip);
+  }
+  if (offset < 0 || offset >= canvas.numPixels()) { return true; }
+  canvas.write(offset, rgb, std::min<uint32_t>(count, canvas.numPixels() - offset));
+  return true;
+}
+
+// The stand-in slave for /pixels/key, /pixels/delta and /fill: mirrors
+// oscReceivePixelOps() and the /fill branch of oscReceiveMessage(), where
+// stageFrame() drops the frame the deltas build on. The packet is parsed
+// once and handed on by address, as in oscReceive().
+struct DeltaSlave {
+  Canvas canvas;
+  int32_t pixelSeq = -1;
+  uint32_t keyRequests = 0;
+};
+
+static void receiveOps(DeltaSlave& slave, const uint8_t* packet, int size) {
+  OSCView view;
+  if (!oscViewParse(packet, size, view)) { return; }
+  int32_t seq, first, count, color;
+  const uint8_t* ops;
+  uint32_t bytes;
+  if (strcmp(view.address, "/fill") == 0) {
+    if (!oscViewInt(view, 0, first) || !oscViewInt(view, 1, count) || !oscViewInt(view, 2, color)) { return; }
+    slave.pixelSeq = -1;
+    slave.canvas.fill(color, first, count);
+    return;
+  }
+  bool keyframe = strcmp(view.address, "/pixels/key") == 0;
+  if (!keyframe && strcmp(view.address, "/pixels/delta") != 0) { return; }
+  if (!oscViewInt(view, 0, seq) || !oscViewBlob(view, 1, ops, bytes)) { return; }
+  if (!keyframe && (slave.pixelSeq < 0 || (uint16_t)seq != (uint16_t)(slave.pixelSeq + 1))) { slave.keyRequests++; return; }
+  if (!pixelDeltaValid(ops, bytes, slave.canvas.numPixels())) { slave.keyRequests++; return; }
+  slave.pixelSeq = -1;
+  if (keyframe) { slave.canvas.clear(); }
+  pixelDeltaApply(slave.canvas, ops, bytes);
+  slave.pixelSeq = (uint16_t)seq;
+}
+
+static bool sameFrame(Canvas& canvas, const std::vector<uint8_t>& frame) {
+  for (uint16_t i = 0; i < canvas.numPixels(); i++) {
+    const uint8_t* rgb = &frame[i * 3];
+    if (canvas.getPixel(i) != (((uint32_t)rgb[0] << 16) | (rgb[1] << 8) | rgb[2])) { return false; }
+  }
+  return true;
+}
+
+static bool checkDeltaBase(int master, int slave, const sockaddr_in& to, std::mt19937& rng) {
+  DeltaSlave stand;
+  for (uint8_t s = 0; s < 3; s++) { stand.canvas.addSegment(12 + s, 30); }
+  if (!stand.canvas.begin()) {
+    printf("FAIL no memory for the canvas\n");
+    return false;
+  }
+  uint16_t pixels = stand.canvas.numPixels();
+  std::vector<uint8_t> black(pixels * 3), a(pixels * 3), b(pixels * 3), c(pixels * 3), filled;
+  for (auto* frame : { &a, &b, &c }) {
+    for (uint8_t& v : *frame) { v = rng(); }
+  }
+  filled = b;
+  for (uint16_t i = 0; i < 30; i++) { filled[i * 3] = 0; filled[i * 3 + 1] = 0xFF; filled[i * 3 + 2] = 0; }
+  auto ops = [pixels](const std::vector<uint8_t>& prev, const std::vector<uint8_t>& next) {
+    std::vector<uint8_t> out(OSC_PACKET_SIZE);
+    out.resize(pixelDeltaEncode(prev.data(), next.data(), pixels, out.data(), out.size()));
+    return out;
+  };
+  struct Step { const char* name; std::vector<uint8_t> packet; const std::vector<uint8_t>& shown; uint32_t keyRequests; };
+  const Step steps[] = {
+    { "keyframe", OscOut("/pixels/key").add(0).add(ops(black, a)).bytes(), a, 0 },
+    { "delta", OscOut("/pixels/delta").add(1).add(ops(a, b)).bytes(), b, 0 },
+    { "/fill", OscOut("/fill").add(0).add(30).add(0x00FF00).bytes(), filled, 0 },
+    { "delta after /fill", OscOut("/pixels/delta").add(2).add(ops(b, c)).bytes(), filled, 1 },
+    { "keyframe after /fill", OscOut("/pixels/key").add(3).add(ops(black, c)).bytes(), c, 1 },
+  };
+  static uint8_t packet[OSC_PACKET_SIZE];
+  for (const Step& step : steps) {
+    pollfd wait = { slave, POLLIN, 0 };
+    if (!udpSend(master, step.packet, to) || poll(&wait, 1, RECEIVE_TIMEOUT_MS) <= 0) {
+      printf("FAIL %s lost\n", step.name);
+      return false;
+    }
+    receiveOps(stand, packet, recv(slave, packet, sizeof(packet), 0));
+    if (!sameFrame(stand.canvas, step.shown) || stand.keyRequests != step.keyRequests) {
+      printf("FAIL after %s: canvas %s, %u keyframe requests\n", step.name,
+             sameFrame(stand.canvas, step.shown) ? "as expected" : "wrong", stand.keyRequests);
+      return false;
+    }
+  }
+  printf("delta after /fill   dropped, keyframe requested\n");
+  return true;
+}
+
+struct Result {
+  bool ok = true;
+  uint32_t packets = 0;
+  double seconds = 0, decodeSeconds = 0;
+};
+
+static Result stream(int master, int slave, const sockaddr_in& to, uint16_t stripPixels, bool perStrip,
+                     uint32_t frames, std::mt19937& rng) {
+  Result result;
+  Canvas canvas;
+  for (uint8_t s = 0; s < 3; s++) { canvas.addSegment(12 + s, stripPixels); }
+  if (!canvas.begin()) {
+    printf("FAIL no memory for the canvas\n");
+    result.ok = false;
+    return result;
+  }
+  std::vector<uint8_t> frame(canvas.numPixels() * 3);
+  static uint8_t packet[OSC_PACKET_SIZE];
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t f = 0; f < frames && result.ok; f++) {
+    for (uint8_t& b : frame) { b = rng(); }
+    std::vector<std::vector<uint8_t>> out;
+    if (perStrip) {
+      for (uint8_t s = 0; s < 3; s++) {
+        auto first = frame.begin() + s * stripPixels * 3;
+        out.push_back(OscOut("/pixels").add(std::vector<uint8_t>(first, first + stripPixels * 3)).add(0).add(s).bytes());
+      }
+    } else {
+      out.push_back(OscOut("/pixels").add(frame).bytes());
+    }
+    for (const auto& data : out) {
+      if (data.size() > OSC_PACKET_SIZE || !udpSend(master, data, to)) {
+        printf("FAIL %zu-byte packet does not fit one datagram\n", data.size());
+        result.ok = false;
+        break;
+      }
+      pollfd wait = { slave, POLLIN, 0 };
+      if (poll(&wait, 1, RECEIVE_TIMEOUT_MS) <= 0) {
+        printf("FAIL packet %u lost\n", result.packets);
+        result.ok = false;
+        break;
+      }
+      int size = recv(slave, packet, sizeof(packet), 0);
+      auto decodeStart = std::chrono::steady_clock::now();
+      receivePixels(canvas, packet, size);
+      result.decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+      result.packets++;
+    }
+    if (result.ok && !sameFrame(canvas, frame)) {
+      printf("FAIL frame %u differs from the one sent\n", f);
+      result.ok = false;
+    }
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+int main(int argc, char** argv) {
+  uint32_t frames = 2000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) { frames = atoi(argv[++i]); }
+  }
+  int master = udpOpen(0), slave = udpOpen(0);
+  if (master < 0 || slave < 0) {
+    printf("Cannot open loopback sockets\n");
+    return 1;
+  }
+  sockaddr_in to = udpAddress("127.0.0.1", udpPort(slave));
+  std::mt19937 rng(1);
+
+  struct Run { const char* name; uint16_t stripPixels; bool perStrip; };
+  const Run runs[] = {
+    { "3 x 30, one packet", 30, false },
+    { "3 x 30, per strip", 30, true },
+    { "3 x 300, per strip", 300, true },
+  };
+  bool ok = true;
+  for (const Run& run : runs) {
+    Result r = stream(master, slave, to, run.stripPixels, run.perStrip, frames, rng);
+    ok &= r.ok;
+    if (!r.ok) { continue; }
+    double fps = frames / r.seconds;
+    printf("%-19s %8.0f packets/s %8.0f fps (%.0fx %d fps), decode + write %.2f us/packet\n", run.name,
+           r.packets / r.seconds, fps, fps / TARGET_FPS, TARGET_FPS, r.decodeSeconds * 1e6 / r.packets);
+  }
+  ok &= checkDeltaBase(master, slave, to, rng);
+  close(master);
+  close(slave);
+  printf("pixel streaming: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// Host tool to find the slaves on the network and provision them by MAC.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/provision.cpp src/osc_view.cpp -o provision
+//   ./provision discover [--plan <first ip>]
+//   ./provision assign <plan file>
+//   options: --to <broadcast address> (255.255.255.255), --port <OSC port> (7001),
+//            --wait <ms per round> (1000), --retries <rounds> (4)
+//
+// discover broadcasts /discover and lists every slave that answers: MAC,
+// device ID, IP, firmware version and uptime. With --plan it prints a plan
+// instead, device IDs 1 to 8 and consecutive addresses from <first ip> in
+// MAC order, to be edited so the IDs match the podiums.
+//
+// assign reads a plan, one slave per line:
+//   24:0A:C4:12:34:56 id=1 ip=192.168.1.101 [any /config/set field=value...]
+// and broadcasts /provision messages for all of them, packed into as few
+// bundles as fit a packet, see src/fleet.h. Each slave applies its own line
+// as one change and restarts if its network settings changed. Slaves that
+// have not acknowledged are sent their line again, up to --retries rounds.
+// Exits non-zero unless every slave acknowledged without error.
+#include "osc_view.h"
+#include "osc_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define MAX_PACKET 1400          // Bundles stay within one Ethernet frame
+#define MAX_DEVICE_ID 8          // Podiums the master knows
+#define DISCOVER_ROUNDS 3
+
+struct Options {
+  std::string to = "255.255.255.255";
+  uint16_t port = 7001;
+  int waitMs = 1000;
+  int retries = 4;
+};
+
+struct Found {
+  int32_t id, uptimeMs;
+  std::string ip, version;
+};
+
+static double nowMs() {
+  static auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Calls `handle` for every OSC message received within `ms`, bundles unpacked.
+template <typename F> static void collect(int fd, int ms, F handle) {
+  uint8_t packet[1500];
+  double end = nowMs() + ms;
+  while (nowMs() < end) {
+    pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, std::max(1, (int)(end - nowMs()))) <= 0) { continue; }
+    int size = recv(fd, packet, sizeof(packet), 0);
+    OSCView view;
+    if (size > 0 && oscViewParse(packet, size, view)) { handle(view); }
+  }
+}
+
+static std::string text(const OSCView& view, uint8_t index) {
+  const char* s;
+  return oscViewString(view, index, s) ? s : "";
+}
+
+static std::map<std::string, Found> discover(int fd, const Options& o) {
+  std::map<std::string, Found> found;
+  for (int round = 0; round < DISCOVER_ROUNDS; round++) { // Again, for slaves that missed one
+    udpSend(fd, OscOut("/discover").bytes(), udpAddress(o.to.c_str(), o.port));
+    collect(fd, o.waitMs / DISCOVER_ROUNDS, [&](const OSCView& view) {
+      if (strcmp(view.address, "/discover/reply") != 0) { return; }
+      Found f = {};
+      oscViewInt(view, 1, f.id);
+      oscViewInt(view, 4, f.uptimeMs);
+      f.ip = text(view, 2);
+      f.version = text(view, 3);
+      found[text(view, 0)] = f;
+    });
+  }
+  return found;
+}
+
+static int runDiscover(int fd, const Options& o, const char* planFrom) {
+  std::map<std::string, Found> found = discover(fd, o);
+  if (planFrom) {
+    uint8_t ip[4];
+    if (sscanf(planFrom, "%hhu.%hhu.%hhu.%hhu", &ip[0], &ip[1], &ip[2], &ip[3]) != 4) { fprintf(stderr, "bad address %s\n", planFrom); return 2; }
+    int id = 1;
+    for (auto& [mac, f] : found) {
+      if (id <= MAX_DEVICE_ID) { printf("%s id=%d ip=%u.%u.%u.%u\n", mac.c_str(), id++, ip[0], ip[1], ip[2], ip[3]); }
+      else { printf("%s ip=%u.%u.%u.%u  # no device ID left, 1-%d\n", mac.c_str(), ip[0], ip[1], ip[2], ip[3], MAX_DEVICE_ID); }
+      ip[3]++;
+    }
+    return found.empty();
+  }
+  printf("%zu slaves\n", found.size());
+  for (auto& [mac, f] : found) {
+    printf("  %s  id %2d  ip %-15s  firmware %-10s  up %.1f s\n", mac.c_str(), f.id, f.ip.c_str(), f.version.c_str(), f.uptimeMs / 1000.0);
+  }
+  return found.empty();
+}
+
+static int runAssign(int fd, const Options& o, const char* planFile) {
+  std::ifstream in(planFile);
+  if (!in) { fprintf(stderr, "cannot read %s\n", planFile); return 2; }
+  std::map<std::string, std::vector<uint8_t>> pending;   // MAC -> its /provision message
+  std::vector<std::string> order;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find('#') != std::string::npos) { line.erase(line.find('#')); }
+    std::istringstream words(line);
+    std::string mac, pair;
+    if (!(words >> mac)) { continue; }
+    std::transform(mac.begin(), mac.end(), mac.begin(), ::toupper);
+    std::replace(mac.begin(), mac.end(), '-', ':');
+    OscOut msg("/provision");
+    msg.add(mac);
+    while (words >> pair) {
+      size_t eq = pair.find('=');
+      if (eq == std::string::npos) { fprintf(stderr, "expected name=value: %s\n", pair.c_str()); return 2; }
+      msg.add(pair.substr(0, eq)).add(pair.substr(eq + 1));
+    }
+    pending[mac] = msg.bytes();
+    order.push_back(mac);
+  }
+  std::map<std::string, std::pair<int32_t, std::string>> acks;
+  int messagesSent = 0, bundlesSent = 0;
+  for (int round = 0; round < o.retries && acks.size() < order.size(); round++) {
+    std::vector<std::vector<uint8_t>> batch;
+    size_t bytes = 16;
+    auto flush = [&]() {
+      if (batch.empty()) { return; }
+      udpSend(fd, oscBundle(batch), udpAddress(o.to.c_str(), o.port));
+      bundlesSent++;
+      batch.clear();
+      bytes = 16;
+    };
+    for (const std::string& mac : order) {
+      if (acks.count(mac)) { continue; }
+      const std::vector<uint8_t>& msg = pending[mac];
+      if (bytes + 4 + msg.size() > MAX_PACKET) { flush(); }
+      batch.push_back(msg);
+      bytes += 4 + msg.size();
+      messagesSent++;
+    }
+    flush();
+    collect(fd, o.waitMs, [&](const OSCView& view) {
+      if (strcmp(view.address, "/provision/ack") != 0) { return; }
+      int32_t ok = 0;
+      oscViewInt(view, 1, ok);
+      std::string mac = text(view, 0);
+      if (pending.count(mac)) { acks[mac] = {ok, text(view, 2)}; }
+    });
+  }
+  int failed = 0;
+  for (const std::string& mac : order) {
+    auto ack = acks.find(mac);
+    if (ack == acks.end()) { printf("  %s  no answer\n", mac.c_str()); failed++; continue; }
+    printf("  %s  %s: %s\n", mac.c_str(), ack->second.first ? "ok" : "FAILED", ack->second.second.c_str());
+    failed += !ack->second.first;
+  }
+  printf("%zu slaves, %d failed, %d /provision messages in %d bundles\n", order.size(), failed, messagesSent, bundlesSent);
+  return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  std::vector<const char*> words;
+  const char* plan = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--to") && i + 1 < argc) { o.to = argv[++i]; }
+    else if (!strcmp(argv[i], "--port") && i + 1 < argc) { o.port = atoi(argv[++i]); }
+    else if (!strcmp(argv[i], "--wait") && i + 1 < argc) { o.waitMs = atoi(argv[++i]); }
+    else if (!strcmp(argv[i], "--retries") && i + 1 < argc) { o.retries = atoi(argv[++i]); }
+    else if (!strcmp(argv[i], "--plan") && i + 1 < argc) { plan = argv[++i]; }
+    else { words.push_back(argv[i]); }
+  }
+  int fd = udpOpen(0);                               // Replies come back to this port
+  if (fd < 0) { perror("socket"); return 2; }
+  if (words.size() == 1 && !strcmp(words[0], "discover")) { return runDiscover(fd, o, plan); }
+  if (words.size() == 2 && !strcmp(words[0], "assign")) { return runAssign(fd, o, words[1]); }
+  fprintf(stderr, "usage: provision discover [--plan <first ip>] | assign <plan file>  [--to addr] [--port n] [--wait ms] [--retries n]\n");
+  return 2;
+}
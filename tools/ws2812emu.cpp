@@ -0,0 +1,163 @@
+// Host emulator for the RMT encoders in lib/Adafruit NeoPixel/esp.c.
+//
+//   g++ -std=c++17 -O2 "-Ilib/Adafruit NeoPixel" tools/ws2812emu.cpp -o ws2812emu
+//   ./ws2812emu
+//
+// Feeds random frames through neoRmtEncode() the way each driver calls it
+// (IDF 4: translator callback on a 40 MHz clock, 32 items per call; IDF 5:
+// one pass on a 10 MHz clock) and captures the items. The capture is then
+// decoded like a pixel would: every item must be high-then-low, its high and
+// low times must sit within +-150 ns of the WS2812_* / WS2811_* nominal
+// values, and the decoded bytes must equal the input. The old per-bit
+// encoder is kept here as a reference, so changes to the encoder can be
+// checked for bit-exact output and speed. So is the loop the IDF 5 driver
+// had before, which sent 800 KHz items whatever the strip: at 800 KHz the
+// IDF 5 output must be bit-exact with it, and at 400 KHz it is reported
+// how far out of WS2811 timing that loop was. Exits non-zero on any mismatch.
+#include "esp_rmt_encode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#define TOLERANCE_NS 150      // WS2812B datasheet, per high or low phase
+#define IDF4_CLOCK_HZ 40000000 // APB 80 MHz, clk_div 2
+#define IDF5_CLOCK_HZ 10000000
+#define IDF4_CHUNK 32          // Half of one 64-item RMT memory block
+
+struct Driver {
+  const char* name;
+  uint32_t clockHz;
+  size_t chunk;                // Items per translator call, 0 = all at once
+};
+
+static const Driver DRIVERS[] = {
+  {"IDF4 translator", IDF4_CLOCK_HZ, IDF4_CHUNK},
+  {"IDF5 rmtWrite", IDF5_CLOCK_HZ, 0},
+};
+
+// The encoder as it was before it moved to esp_rmt_encode.h.
+static void referenceEncode(const uint8_t* src, size_t n, uint32_t* dest, const neo_rmt_timing_t& t) {
+  for (size_t b = 0; b < n; b++) {
+    for (int bit = 0; bit < 8; bit++) { *dest++ = (src[b] & (1 << (7 - bit))) ? t.bit1 : t.bit0; }
+  }
+}
+
+// The IDF 5 loop as it was: 8/4 ticks for a 1, 4/8 for a 0 at 10 MHz, for
+// 800 and 400 KHz strips alike.
+static void legacyIdf5Encode(const uint8_t* src, size_t n, uint32_t* dest) {
+  for (size_t b = 0; b < n; b++) {
+    for (int bit = 0; bit < 8; bit++) { *dest++ = (src[b] & (1 << (7 - bit))) ? NEO_RMT_ITEM(8, 4) : NEO_RMT_ITEM(4, 8); }
+  }
+}
+
+static size_t capture(const Driver& d, const neo_rmt_timing_t& t, const uint8_t* src, size_t n, uint32_t* items) {
+  if (!d.chunk) {
+    size_t done;
+    return neoRmtEncode(src, n, items, n * 8, &t, &done);
+  }
+  size_t consumed = 0, count = 0;
+  while (consumed < n) {
+    size_t done;
+    count += neoRmtEncode(src + consumed, n - consumed, items + count, d.chunk, &t, &done);
+    if (!done) { return 0; } // No progress, driver would hang
+    consumed += done;
+  }
+  return count;
+}
+
+struct Check {
+  uint32_t errors = 0;
+  uint32_t minHigh[2] = {UINT32_MAX, UINT32_MAX}, maxHigh[2] = {0, 0};
+  uint32_t minLow[2] = {UINT32_MAX, UINT32_MAX}, maxLow[2] = {0, 0};
+};
+
+static uint32_t ns(uint32_t ticks, uint32_t clockHz) { return (uint64_t)ticks * 1000000000ULL / clockHz; }
+
+static bool within(uint32_t value, uint32_t nominal) {
+  return value + TOLERANCE_NS >= nominal && value <= nominal + TOLERANCE_NS;
+}
+
+// Decodes items back to bytes like a WS281x input stage: a high phase longer
+// than halfway between T0H and T1H is a 1.
+static void decode(const uint32_t* items, size_t count, uint32_t clockHz, bool is800KHz,
+                   const uint8_t* expect, Check& check) {
+  uint32_t t0h = is800KHz ? WS2812_T0H_NS : WS2811_T0H_NS, t0l = is800KHz ? WS2812_T0L_NS : WS2811_T0L_NS;
+  uint32_t t1h = is800KHz ? WS2812_T1H_NS : WS2811_T1H_NS, t1l = is800KHz ? WS2812_T1L_NS : WS2811_T1L_NS;
+  uint8_t byte = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t item = items[i];
+    uint32_t high = ns(item & 0x7FFF, clockHz), low = ns((item >> 16) & 0x7FFF, clockHz);
+    if (!(item & 0x8000) || (item & 0x80000000)) { check.errors++; } // Must be high, then low
+    int bit = high > (t0h + t1h) / 2;
+    if (!within(high, bit ? t1h : t0h) || !within(low, bit ? t1l : t0l)) { check.errors++; }
+    if (high < check.minHigh[bit]) { check.minHigh[bit] = high; }
+    if (high > check.maxHigh[bit]) { check.maxHigh[bit] = high; }
+    if (low < check.minLow[bit]) { check.minLow[bit] = low; }
+    if (low > check.maxLow[bit]) { check.maxLow[bit] = low; }
+    byte = (byte << 1) | bit;
+    if ((i & 7) == 7 && byte != expect[i / 8]) { check.errors++; }
+  }
+}
+
+template <typename F> static double timeUs(int reps, F f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++) { f(r); }
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / reps;
+}
+
+int main() {
+  const uint16_t SIZES[] = {90, 300, 1000};
+  uint32_t failures = 0;
+  srand(1);
+  for (const Driver& d : DRIVERS) {
+    for (int khz800 = 1; khz800 >= 0; khz800--) {
+      neo_rmt_timing_t t = neoRmtTiming(d.clockHz, khz800);
+      printf("%s, %s: 0 = %u/%u ticks, 1 = %u/%u ticks\n", d.name, khz800 ? "800 KHz" : "400 KHz",
+             t.bit0 & 0x7FFF, (t.bit0 >> 16) & 0x7FFF, t.bit1 & 0x7FFF, (t.bit1 >> 16) & 0x7FFF);
+      for (uint16_t pixels : SIZES) {
+        size_t n = pixels * 3;
+        std::vector<uint8_t> frame(n);
+        std::vector<uint32_t> items(n * 8), reference(n * 8);
+        Check check;
+        for (int f = 0; f < 50; f++) {
+          for (auto& b : frame) { b = rand(); }
+          if (f == 0) { memset(frame.data(), 0x00, n / 2); memset(frame.data() + n / 2, 0xFF, n - n / 2); }
+          size_t count = capture(d, t, frame.data(), n, items.data());
+          referenceEncode(frame.data(), n, reference.data(), t);
+          if (count != n * 8 || memcmp(items.data(), reference.data(), n * 8 * sizeof(uint32_t))) { check.errors++; }
+          decode(items.data(), count, d.clockHz, khz800, frame.data(), check);
+        }
+        double fast = timeUs(2000, [&](int r) { frame[0] = r; capture(d, t, frame.data(), n, items.data()); });
+        double ref = timeUs(2000, [&](int r) { frame[0] = r; referenceEncode(frame.data(), n, reference.data(), t); });
+        printf("  %4u px: %s, high 0 %u-%u ns, 1 %u-%u ns, low 0 %u-%u ns, 1 %u-%u ns, encode %.2f us (reference %.2f us)\n",
+               pixels, check.errors ? "FAIL" : "ok", check.minHigh[0], check.maxHigh[0], check.minHigh[1], check.maxHigh[1],
+               check.minLow[0], check.maxLow[0], check.minLow[1], check.maxLow[1], fast, ref);
+        failures += check.errors;
+      }
+    }
+  }
+  // IDF 5 against its old loop, on one 300-pixel frame per speed
+  std::vector<uint8_t> frame(900);
+  std::vector<uint32_t> items(frame.size() * 8), legacy(frame.size() * 8);
+  for (auto& b : frame) { b = rand(); }
+  legacyIdf5Encode(frame.data(), frame.size(), legacy.data());
+  for (int khz800 = 1; khz800 >= 0; khz800--) {
+    size_t done;
+    neo_rmt_timing_t t = neoRmtTiming(IDF5_CLOCK_HZ, khz800);
+    neoRmtEncode(frame.data(), frame.size(), items.data(), items.size(), &t, &done);
+    bool same = memcmp(items.data(), legacy.data(), items.size() * sizeof(uint32_t)) == 0;
+    Check old;
+    decode(legacy.data(), legacy.size(), IDF5_CLOCK_HZ, khz800, frame.data(), old);
+    if (khz800) {
+      printf("IDF5 800 KHz against the old loop: %s\n", same ? "bit-exact" : "FAIL, output changed");
+      failures += !same;
+    } else {
+      printf("IDF5 400 KHz: WS2811 timing now; the old loop's 800 KHz items give %u timing and byte errors as WS2811\n",
+             old.errors);
+    }
+  }
+  printf(failures ? "%u errors\n" : "all frames bit-exact and within timing\n", failures);
+  return failures ? 1 : 0;
+}